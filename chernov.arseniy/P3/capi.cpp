@@ -0,0 +1,67 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+
+namespace chernov {
+  namespace {
+    bool isValidMatrix(const int * mtx, size_t stride, size_t rows, size_t cols)
+    {
+      return rows * cols == 0 || (mtx && stride >= cols);
+    }
+
+    void copyRows(const int * from, size_t from_stride, size_t rows, size_t cols, int * to, size_t to_stride)
+    {
+      for (size_t i = 0; i < rows; ++i) {
+        std::copy(from + i * from_stride, from + i * from_stride + cols, to + i * to_stride);
+      }
+    }
+  }
+}
+
+unsigned chernov_capiVersion(void)
+{
+  return CHERNOV_CAPI_VERSION;
+}
+
+int chernov_fllIncWav(int * mtx, size_t stride, size_t rows, size_t cols)
+{
+  if (!chernov::isValidMatrix(mtx, stride, rows, cols)) {
+    return CHERNOV_EINVAL;
+  }
+  if (rows * cols == 0) {
+    return CHERNOV_OK;
+  }
+  try {
+    std::vector< int > dense(rows * cols);
+    chernov::copyRows(mtx, stride, rows, cols, dense.data(), cols);
+    chernov::fllIncWav(dense.data(), rows, cols);
+    chernov::copyRows(dense.data(), cols, rows, cols, mtx, stride);
+  } catch (const std::overflow_error &) {
+    return CHERNOV_EOVERFLOW;
+  } catch (const std::bad_alloc &) {
+    return CHERNOV_ENOMEM;
+  }
+  return CHERNOV_OK;
+}
+
+int chernov_minSumMdg(const int * mtx, size_t stride, size_t rows, size_t cols, int * result)
+{
+  if (!chernov::isValidMatrix(mtx, stride, rows, cols) || !result) {
+    return CHERNOV_EINVAL;
+  }
+  try {
+    std::vector< int > dense;
+    if (stride != cols && rows * cols != 0) {
+      dense.resize(rows * cols);
+      chernov::copyRows(mtx, stride, rows, cols, dense.data(), cols);
+      mtx = dense.data();
+    }
+    *result = chernov::minSumMdg(mtx, rows, cols);
+  } catch (const std::bad_alloc &) {
+    return CHERNOV_ENOMEM;
+  }
+  return CHERNOV_OK;
+}
@@ -0,0 +1,34 @@
+#ifndef CHERNOV_CAPI_H
+#define CHERNOV_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHERNOV_CAPI_VERSION 1
+
+#define CHERNOV_OK 0
+#define CHERNOV_EINVAL 1
+#define CHERNOV_EOVERFLOW 2
+#define CHERNOV_ENOMEM 3
+
+/*
+ * Kernels over caller-owned row-major buffers. Row i of a rows x cols
+ * matrix starts at mtx + i * stride, and stride must be at least cols.
+ */
+
+unsigned chernov_capiVersion(void);
+
+/* Adds the wave increments in place; on overflow the matrix is not modified */
+int chernov_fllIncWav(int * mtx, size_t stride, size_t rows, size_t cols);
+
+/* Minimum anti-diagonal sum, 0 for an empty matrix */
+int chernov_minSumMdg(const int * mtx, size_t stride, size_t rows, size_t cols, int * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#include "diag_sums.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace chernov {
+  namespace {
+    void buildDiagonals(const int * mtx, DiagonalSums & sums, size_t begin, size_t end)
+    {
+      const size_t rows = sums.rows, cols = sums.cols;
+      for (size_t d = begin; d < end; ++d) {
+        size_t i = d < cols ? 0 : d - cols + 1;
+        size_t j = d < cols ? cols - 1 - d : 0;
+        long long sum = 0;
+        for (; i < rows && j < cols; ++i, ++j) {
+          sum += mtx[i * cols + j];
+          sums.main[i * cols + j] = sum;
+        }
+      }
+      for (size_t d = begin; d < end; ++d) {
+        size_t i = d < cols ? 0 : d - cols + 1;
+        size_t j = d < cols ? d : cols - 1;
+        long long sum = 0;
+        for (; i < rows; ++i) {
+          sum += mtx[i * cols + j];
+          sums.anti[i * cols + j] = sum;
+          if (j-- == 0) {
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+void chernov::buildDiagonalSums(const int * mtx, size_t rows, size_t cols, size_t threads, DiagonalSums & sums)
+{
+  sums.rows = rows;
+  sums.cols = cols;
+  sums.main.assign(rows * cols, 0);
+  sums.anti.assign(rows * cols, 0);
+  if (rows * cols == 0) {
+    return;
+  }
+  const size_t diagonals = rows + cols - 1;
+  threads = std::max< size_t >(1, std::min(threads, diagonals));
+  std::vector< std::thread > workers;
+  size_t started = 1;
+  try {
+    for (; started < threads; ++started) {
+      workers.emplace_back(buildDiagonals, mtx, std::ref(sums), diagonals * started / threads, diagonals * (started + 1) / threads);
+    }
+  } catch (const std::system_error &) {
+  }
+  buildDiagonals(mtx, sums, 0, diagonals / threads);
+  buildDiagonals(mtx, sums, diagonals * started / threads, diagonals);
+  for (std::thread & w: workers) {
+    w.join();
+  }
+}
+
+long long chernov::getMainSegment(const DiagonalSums & sums, size_t row, size_t col, size_t len)
+{
+  const size_t cols = sums.cols;
+  long long before = (row && col) ? sums.main[(row - 1) * cols + col - 1] : 0;
+  return sums.main[(row + len - 1) * cols + col + len - 1] - before;
+}
+
+long long chernov::getAntiSegment(const DiagonalSums & sums, size_t row, size_t col, size_t len)
+{
+  const size_t cols = sums.cols;
+  long long before = (row && col + 1 < cols) ? sums.anti[(row - 1) * cols + col + 1] : 0;
+  return sums.anti[(row + len - 1) * cols + col + 1 - len] - before;
+}
+
+long long chernov::minAntiInRect(const DiagonalSums & sums, size_t row0, size_t col0, size_t row1, size_t col1)
+{
+  long long res = std::numeric_limits< long long >::max();
+  for (size_t j = col0; j < col1; ++j) {
+    res = std::min(res, getAntiSegment(sums, row0, j, std::min(row1 - row0, j - col0 + 1)));
+  }
+  for (size_t i = row0 + 1; i < row1; ++i) {
+    res = std::min(res, getAntiSegment(sums, i, col1 - 1, std::min(row1 - i, col1 - col0)));
+  }
+  return res;
+}
+
+long long chernov::minMainInRect(const DiagonalSums & sums, size_t row0, size_t col0, size_t row1, size_t col1)
+{
+  long long res = std::numeric_limits< long long >::max();
+  for (size_t j = col0; j < col1; ++j) {
+    res = std::min(res, getMainSegment(sums, row0, j, std::min(row1 - row0, col1 - j)));
+  }
+  for (size_t i = row0 + 1; i < row1; ++i) {
+    res = std::min(res, getMainSegment(sums, i, col0, std::min(row1 - i, col1 - col0)));
+  }
+  return res;
+}
+
+std::ostream & chernov::answerDiagonalQueries(std::istream & queries, std::ostream & output, const DiagonalSums & sums)
+{
+  std::string kind;
+  size_t row0 = 0, col0 = 0, row1 = 0, col1 = 0;
+  while (queries >> kind >> row0 >> col0 >> row1 >> col1) {
+    bool inside = row0 < row1 && col0 < col1 && row1 <= sums.rows && col1 <= sums.cols;
+    if (!inside || (kind != "A" && kind != "M")) {
+      output << "-\n";
+    } else if (kind == "A") {
+      output << minAntiInRect(sums, row0, col0, row1, col1) << "\n";
+    } else {
+      output << minMainInRect(sums, row0, col0, row1, col1) << "\n";
+    }
+  }
+  return output;
+}
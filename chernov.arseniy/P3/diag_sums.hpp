@@ -0,0 +1,27 @@
+#ifndef CHERNOV_DIAG_SUMS_HPP
+#define CHERNOV_DIAG_SUMS_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace chernov {
+  // Running sums along both diagonal directions, ending at each cell:
+  // main[i][j] = mtx[i][j] + main[i - 1][j - 1], anti[i][j] = mtx[i][j] + anti[i - 1][j + 1].
+  struct DiagonalSums {
+    size_t rows;
+    size_t cols;
+    std::vector< long long > main;
+    std::vector< long long > anti;
+  };
+
+  void buildDiagonalSums(const int * mtx, size_t rows, size_t cols, size_t threads, DiagonalSums & sums);
+  long long getMainSegment(const DiagonalSums & sums, size_t row, size_t col, size_t len);
+  long long getAntiSegment(const DiagonalSums & sums, size_t row, size_t col, size_t len);
+  long long minAntiInRect(const DiagonalSums & sums, size_t row0, size_t col0, size_t row1, size_t col1);
+  long long minMainInRect(const DiagonalSums & sums, size_t row0, size_t col0, size_t row1, size_t col1);
+  std::ostream & answerDiagonalQueries(std::istream & queries, std::ostream & output, const DiagonalSums & sums);
+}
+
+#endif
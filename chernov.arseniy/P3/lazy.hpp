@@ -0,0 +1,168 @@
+#ifndef CHERNOV_LAZY_HPP
+#define CHERNOV_LAZY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace chernov {
+  // Lazy matrix expressions. A view computes a cell on demand from the view
+  // it wraps; reductions and writers take any view, so a chain such as
+  // minSumMdg(incWav(MatrixView(...))) is instantiated as a single loop over
+  // the source with no intermediate matrix.
+  class MatrixView {
+  public:
+    MatrixView(const int * mtx, size_t rows, size_t cols):
+      mtx_(mtx),
+      rows_(rows),
+      cols_(cols)
+    {}
+
+    size_t rows() const
+    {
+      return rows_;
+    }
+
+    size_t cols() const
+    {
+      return cols_;
+    }
+
+    long long operator()(size_t y, size_t x) const
+    {
+      return mtx_[y * cols_ + x];
+    }
+
+  private:
+    const int * mtx_;
+    size_t rows_;
+    size_t cols_;
+  };
+
+  // fllIncWav never leaves the outer ring: its walk circles it for
+  // rows * cols steps adding 1 each time, so a ring cell at position pos
+  // is visited (rows * cols - 1 - pos) / perimeter + 1 times and inner
+  // cells keep their values.
+  inline size_t getWavePerimeter(size_t rows, size_t cols)
+  {
+    return (rows == 1 || cols == 1) ? rows * cols : 2 * (rows + cols) - 4;
+  }
+
+  inline size_t getWavePosition(size_t y, size_t x, size_t rows, size_t cols)
+  {
+    if (y == 0) {
+      return x;
+    } else if (x == cols - 1) {
+      return cols - 1 + y;
+    } else if (y == rows - 1) {
+      return (cols - 1) + (rows - 1) + (cols - 1 - x);
+    } else if (x == 0) {
+      return 2 * (cols - 1) + (rows - 1) + (rows - 1 - y);
+    }
+    return std::numeric_limits< size_t >::max();
+  }
+
+  inline size_t getWaveVisits(size_t y, size_t x, size_t rows, size_t cols)
+  {
+    size_t pos = getWavePosition(y, x, rows, cols);
+    return pos < rows * cols ? (rows * cols - 1 - pos) / getWavePerimeter(rows, cols) + 1 : 0;
+  }
+
+  template< class E >
+  class IncWavView {
+  public:
+    explicit IncWavView(const E & base):
+      base_(base)
+    {}
+
+    size_t rows() const
+    {
+      return base_.rows();
+    }
+
+    size_t cols() const
+    {
+      return base_.cols();
+    }
+
+    const E & base() const
+    {
+      return base_;
+    }
+
+    long long operator()(size_t y, size_t x) const
+    {
+      return base_(y, x) + static_cast< long long >(getWaveVisits(y, x, rows(), cols()));
+    }
+
+  private:
+    E base_;
+  };
+
+  template< class E >
+  IncWavView< E > incWav(const E & base)
+  {
+    return IncWavView< E >(base);
+  }
+
+  // Throws the same error as fllIncWav: the walk reports the cell that went
+  // past INT_MAX first, i.e. the one with the earliest overflowing step.
+  template< class E >
+  void checkIncWav(const IncWavView< E > & wave)
+  {
+    const size_t rows = wave.rows(), cols = wave.cols();
+    const long long int_max = std::numeric_limits< int >::max();
+    unsigned long long first_step = std::numeric_limits< unsigned long long >::max();
+    size_t first_bad = 0;
+    for (size_t y = 0; y < rows; ++y) {
+      for (size_t x = 0; x < cols; ++x) {
+        if (wave(y, x) > int_max) {
+          unsigned long long headroom = static_cast< unsigned long long >(int_max - wave.base()(y, x));
+          unsigned long long step = getWavePosition(y, x, rows, cols) + headroom * getWavePerimeter(rows, cols);
+          first_bad = step < first_step ? y * cols + x : first_bad;
+          first_step = step < first_step ? step : first_step;
+        }
+      }
+    }
+    if (first_step != std::numeric_limits< unsigned long long >::max()) {
+      throw std::overflow_error("Wave increment overflow at " + std::to_string(first_bad / cols) + " " + std::to_string(first_bad % cols));
+    }
+  }
+
+  template< class E >
+  long long minSumMdg(const E & mtx)
+  {
+    const size_t rows = mtx.rows(), cols = mtx.cols();
+    if (rows * cols == 0) {
+      return 0;
+    }
+    long long min_sum = std::numeric_limits< long long >::max();
+    for (size_t d = 0; d < rows + cols - 1; ++d) {
+      size_t y = d < cols ? 0 : d - cols + 1;
+      size_t x = d - y;
+      size_t len = std::min(rows - y, x + 1);
+      long long sum = 0;
+      for (size_t k = 0; k < len; ++k) {
+        sum += mtx(y + k, x - k);
+      }
+      min_sum = sum < min_sum ? sum : min_sum;
+    }
+    return min_sum;
+  }
+
+  template< class E >
+  std::ostream & writeCells(std::ostream & output, const E & mtx)
+  {
+    for (size_t y = 0; y < mtx.rows(); ++y) {
+      for (size_t x = 0; x < mtx.cols(); ++x) {
+        output << " " << mtx(y, x);
+      }
+    }
+    return output;
+  }
+}
+
+#endif
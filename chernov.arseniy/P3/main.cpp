@@ -1,14 +1,25 @@
 #include <iostream>
 #include <fstream>
-#include <limits>
 #include <cctype>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include "diag_sums.hpp"
+#include "lazy.hpp"
+#include "matrix.hpp"
+#include "npy.hpp"
+#include "row_index.hpp"
 
 namespace chernov {
   std::istream & matrixInput(std::istream & input, int * mtx, size_t rows, size_t cols);
-  void fllIncWav(int * mtx, size_t rows, size_t cols);
-  int minSumMdg(const int * mtx, size_t rows, size_t cols);
-  int getSumAntiDiagonal(const int * mtx, size_t x, size_t y, size_t rows, size_t cols);
-  int processMatrix(std::istream & input, std::ostream & output, int * matrix, size_t rows, size_t cols);
+  int transformMatrix(std::ostream & output, int * matrix, size_t rows, size_t cols, bool npy);
+  long long getWaveMinSum(const int * matrix, size_t rows, size_t cols);
+  int writeLazyWave(std::ostream & output, int min_sum, const int * matrix, size_t rows, size_t cols);
+  int processMatrix(std::istream & input, std::ostream & output, int * matrix, size_t rows, size_t cols, bool npy);
+  size_t getEnvSize(const char * name, size_t fallback);
+  void processDiagonalQueries(const char * path, const int * matrix, size_t rows, size_t cols);
+  int processIndexed(const char * in, const char * sidecar, std::ostream & output, bool npy);
 }
 
 std::istream & chernov::matrixInput(std::istream & input, int * mtx, size_t rows, size_t cols)
@@ -19,78 +30,118 @@ std::istream & chernov::matrixInput(std::istream & input, int * mtx, size_t rows
   return input;
 }
 
-void chernov::fllIncWav(int * mtx, size_t rows, size_t cols)
+int chernov::transformMatrix(std::ostream & output, int * matrix, size_t rows, size_t cols, bool npy)
 {
-  int add = 1;
-  size_t x = 0, y = 0, count = 0, border = 0;
-  while (count++ < rows * cols) {
-    mtx[cols * y + x] += add;
-    if (y == border && x != cols - border - 1) {
-      ++x;
-    } else if (x == cols - border - 1 && y != rows - border - 1) {
-      ++y;
-    } else if (y == rows - border - 1 && x != border) {
-      --x;
-    } else if (x == border) {
-      if (y == border - 1) {
-        ++add;
-        ++border;
-        ++x;
-      } else {
-        --y;
-      }
+  int min_sum = chernov::minSumMdg(matrix, rows, cols);
+  const char * queries = std::getenv("CHERNOV_DIAG_QUERIES");
+  if (queries) {
+    chernov::processDiagonalQueries(queries, matrix, rows, cols);
+  }
+  const char * metric = std::getenv("CHERNOV_WAVE_METRIC");
+  try {
+    if (metric) {
+      long long wave_min_sum = chernov::getWaveMinSum(matrix, rows, cols);
+      std::ofstream metric_output(metric);
+      metric_output << wave_min_sum << "\n";
+    }
+    if (std::getenv("CHERNOV_LAZY") && !npy) {
+      return chernov::writeLazyWave(output, min_sum, matrix, rows, cols);
     }
+    chernov::fllIncWav(matrix, rows, cols);
+  } catch (const std::overflow_error & e) {
+    std::cerr << e.what() << "\n";
+    return 2;
+  }
+
+  if (npy) {
+    chernov::writeNpy(output, matrix, rows, cols);
+    std::cout << min_sum << "\n";
+    return 0;
   }
+  output << min_sum << "\n";
+  output << rows << " " << cols;
+  for (size_t i = 0; i < rows * cols; ++i) {
+    output << " " << matrix[i];
+  }
+  output << "\n";
+
+  return 0;
 }
 
-int chernov::getSumAntiDiagonal(const int * mtx, size_t x, size_t y, size_t rows, size_t cols)
+long long chernov::getWaveMinSum(const int * matrix, size_t rows, size_t cols)
 {
-  int sum = 0;
-  do {
-    sum += mtx[y * cols + x];
-  } while (x-- > 0 && ++y < rows);
-  return sum;
+  auto wave = chernov::incWav(chernov::MatrixView(matrix, rows, cols));
+  chernov::checkIncWav(wave);
+  return chernov::minSumMdg(wave);
 }
 
-int chernov::minSumMdg(const int * mtx, size_t rows, size_t cols)
+int chernov::writeLazyWave(std::ostream & output, int min_sum, const int * matrix, size_t rows, size_t cols)
 {
-  if (rows * cols == 0) {
-    return 0;
-  }
-  int min_sum = std::numeric_limits< int >::max(), sum = 0;
-
-  for (size_t x = 0; x < cols; ++x) {
-    sum = getSumAntiDiagonal(mtx, x, 0, rows, cols);
-    if (sum < min_sum) {
-      min_sum = sum;
-    }
-  }
-  for (size_t y = 1; y < rows; ++y) {
-    sum = getSumAntiDiagonal(mtx, cols - 1, y, rows, cols);
-    if (sum < min_sum) {
-      min_sum = sum;
-    }
-  }
-  return min_sum;
+  auto wave = chernov::incWav(chernov::MatrixView(matrix, rows, cols));
+  chernov::checkIncWav(wave);
+  output << min_sum << "\n";
+  output << rows << " " << cols;
+  chernov::writeCells(output, wave);
+  output << "\n";
+  return 0;
 }
 
-int chernov::processMatrix(std::istream & input, std::ostream & output, int * matrix, size_t rows, size_t cols)
+int chernov::processMatrix(std::istream & input, std::ostream & output, int * matrix, size_t rows, size_t cols, bool npy)
 {
   if (!chernov::matrixInput(input, matrix, rows, cols)) {
     std::cerr << "Incorrect input\n";
     return 2;
   }
+  return chernov::transformMatrix(output, matrix, rows, cols, npy);
+}
 
-  output << chernov::minSumMdg(matrix, rows, cols) << "\n";
+size_t chernov::getEnvSize(const char * name, size_t fallback)
+{
+  const char * value = std::getenv(name);
+  char * end = nullptr;
+  unsigned long long res = value ? std::strtoull(value, &end, 10) : 0;
+  return (value && *value && *end == '\0' && res > 0) ? res : fallback;
+}
 
-  chernov::fllIncWav(matrix, rows, cols);
-  output << rows << " " << cols;
-  for (size_t i = 0; i < rows * cols; ++i) {
-    output << " " << matrix[i];
+void chernov::processDiagonalQueries(const char * path, const int * matrix, size_t rows, size_t cols)
+{
+  DiagonalSums sums{0, 0, {}, {}};
+  size_t threads = getEnvSize("CHERNOV_DIAG_THREADS", std::max(1u, std::thread::hardware_concurrency()));
+  chernov::buildDiagonalSums(matrix, rows, cols, threads, sums);
+  std::ifstream input(path);
+  const char * answers = std::getenv("CHERNOV_DIAG_OUT");
+  if (answers) {
+    std::ofstream output(answers);
+    chernov::answerDiagonalQueries(input, output, sums);
+  } else {
+    chernov::answerDiagonalQueries(input, std::cout, sums);
   }
-  output << "\n";
+}
 
-  return 0;
+int chernov::processIndexed(const char * in, const char * sidecar, std::ostream & output, bool npy)
+{
+  MappedFile file(in);
+  RowIndex index{0, 0, 0, 0, 0, {}, {}};
+  bool cached = file.isOpen() && *sidecar && loadRowIndex(sidecar, index);
+  cached = cached && index.fileSize == file.size() && index.fileTime == file.mtime();
+  if (!file.isOpen() || (!cached && !buildRowIndex(file.data(), file.size(), getEnvSize("CHERNOV_INDEX_STRIDE", 256), index))) {
+    std::cerr << "Incorrect input\n";
+    return 2;
+  }
+  if (!cached && *sidecar) {
+    index.fileTime = file.mtime();
+    if (!saveRowIndex(sidecar, index)) {
+      std::cerr << "Cannot write row index " << sidecar << "\n";
+    }
+  }
+
+  size_t threads = getEnvSize("CHERNOV_INDEX_THREADS", std::max(1u, std::thread::hardware_concurrency()));
+  std::vector< int > matrix(index.rows * index.cols);
+  if (!chernov::loadMatrixParallel(file.data(), file.size(), index, matrix.data(), threads)) {
+    std::cerr << "Incorrect input\n";
+    return 2;
+  }
+  return chernov::transformMatrix(output, matrix.data(), index.rows, index.cols, npy);
 }
 
 int main(int argc, char ** argv)
@@ -109,8 +160,28 @@ int main(int argc, char ** argv)
     return 1;
   }
 
+  const bool npy = chernov::isNpyPath(argv[3]);
+  const std::ios::openmode out_mode = npy ? std::ios::out | std::ios::binary : std::ios::out;
+  if (chernov::isNpyPath(argv[2])) {
+    chernov::NpyMatrix matrix;
+    try {
+      matrix.open(argv[2]);
+    } catch (const std::exception & e) {
+      std::cerr << e.what() << "\n";
+      return 2;
+    }
+    std::ofstream output(argv[3], out_mode);
+    return chernov::transformMatrix(output, matrix.data(), matrix.rows(), matrix.cols(), npy);
+  }
+
+  const char * sidecar = std::getenv("CHERNOV_INDEX");
+  if (sidecar) {
+    std::ofstream output(argv[3], out_mode);
+    return chernov::processIndexed(argv[2], sidecar, output, npy);
+  }
+
   std::ifstream input(argv[2]);
-  std::ofstream output(argv[3]);
+  std::ofstream output(argv[3], out_mode);
   size_t rows = 0, cols = 0;
   input >> rows >> cols;
   if (!input) {
@@ -121,11 +192,11 @@ int main(int argc, char ** argv)
   if (argv[1][0] == '1') {
     constexpr size_t MAX_STATIC_MATRIX_SIZE = 10000;
     int matrix[MAX_STATIC_MATRIX_SIZE] = {};
-    return chernov::processMatrix(input, output, matrix, rows, cols);
+    return chernov::processMatrix(input, output, matrix, rows, cols, npy);
   }
 
   int * matrix = new int[rows * cols];
-  int result = chernov::processMatrix(input, output, matrix, rows, cols);
+  int result = chernov::processMatrix(input, output, matrix, rows, cols, npy);
   delete [] matrix;
   return result;
 }
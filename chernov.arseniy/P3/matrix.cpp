@@ -0,0 +1,75 @@
+#include "matrix.hpp"
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+void chernov::checkWaveOverflow(bool overflow, size_t cell, size_t cols)
+{
+  if (overflow) {
+    throw std::overflow_error("Wave increment overflow at " + std::to_string(cell / cols) + " " + std::to_string(cell % cols));
+  }
+}
+
+void chernov::fllIncWav(int * mtx, size_t rows, size_t cols)
+{
+  int add = 1;
+  size_t x = 0, y = 0, count = 0, border = 0;
+  bool overflowed = false;
+  size_t first_bad = 0;
+  while (count++ < rows * cols) {
+    size_t cell = cols * y + x;
+    unsigned value = static_cast< unsigned >(mtx[cell]);
+    unsigned sum = value + static_cast< unsigned >(add);
+    bool overflow = ((value ^ sum) & (static_cast< unsigned >(add) ^ sum)) >> 31;
+    mtx[cell] = static_cast< int >(sum);
+    first_bad = overflow && !overflowed ? cell : first_bad;
+    overflowed = overflowed || overflow;
+    if (y == border && x != cols - border - 1) {
+      ++x;
+    } else if (x == cols - border - 1 && y != rows - border - 1) {
+      ++y;
+    } else if (y == rows - border - 1 && x != border) {
+      --x;
+    } else if (x == border) {
+      if (y == border - 1) {
+        ++add;
+        ++border;
+        ++x;
+      } else {
+        --y;
+      }
+    }
+  }
+  checkWaveOverflow(overflowed, first_bad, cols);
+}
+
+int chernov::getSumAntiDiagonal(const int * mtx, size_t x, size_t y, size_t rows, size_t cols)
+{
+  int sum = 0;
+  do {
+    sum += mtx[y * cols + x];
+  } while (x-- > 0 && ++y < rows);
+  return sum;
+}
+
+int chernov::minSumMdg(const int * mtx, size_t rows, size_t cols)
+{
+  if (rows * cols == 0) {
+    return 0;
+  }
+  int min_sum = std::numeric_limits< int >::max(), sum = 0;
+
+  for (size_t x = 0; x < cols; ++x) {
+    sum = getSumAntiDiagonal(mtx, x, 0, rows, cols);
+    if (sum < min_sum) {
+      min_sum = sum;
+    }
+  }
+  for (size_t y = 1; y < rows; ++y) {
+    sum = getSumAntiDiagonal(mtx, cols - 1, y, rows, cols);
+    if (sum < min_sum) {
+      min_sum = sum;
+    }
+  }
+  return min_sum;
+}
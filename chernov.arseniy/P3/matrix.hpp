@@ -0,0 +1,13 @@
+#ifndef CHERNOV_MATRIX_HPP
+#define CHERNOV_MATRIX_HPP
+
+#include <cstddef>
+
+namespace chernov {
+  void checkWaveOverflow(bool overflow, size_t cell, size_t cols);
+  void fllIncWav(int * mtx, size_t rows, size_t cols);
+  int minSumMdg(const int * mtx, size_t rows, size_t cols);
+  int getSumAntiDiagonal(const int * mtx, size_t x, size_t y, size_t rows, size_t cols);
+}
+
+#endif
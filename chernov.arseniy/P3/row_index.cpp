@@ -0,0 +1,345 @@
+#include "row_index.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace chernov {
+  namespace {
+    const char INDEX_MAGIC[8] = {'C', 'H', 'R', 'O', 'W', 'I', 'X', '1'};
+
+    bool isBlank(char c)
+    {
+      return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    const size_t BLOCK = 16;
+
+    unsigned blankMask(const char * p)
+    {
+#if defined(__SSE2__)
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast< const __m128i * >(p));
+      __m128i space = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+      __m128i ctrl = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+      ctrl = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8('\r' - '\t')), ctrl);
+      return static_cast< unsigned >(_mm_movemask_epi8(_mm_or_si128(space, ctrl)));
+#else
+      unsigned mask = 0;
+      for (size_t k = 0; k < BLOCK; ++k) {
+        mask |= static_cast< unsigned >(isBlank(p[k])) << k;
+      }
+      return mask;
+#endif
+    }
+
+    const char * skipBlanks(const char * p, const char * end)
+    {
+      while (p != end && isBlank(*p)) {
+        ++p;
+      }
+      return p;
+    }
+
+    const char * skipTokens(const char * p, const char * end, size_t count)
+    {
+      for (size_t k = 0; k < count && p != end; ++k) {
+        p = skipBlanks(p, end);
+        while (p != end && !isBlank(*p)) {
+          ++p;
+        }
+      }
+      return skipBlanks(p, end);
+    }
+
+    const char * parseInt(const char * p, const char * end, int & value)
+    {
+      p = skipBlanks(p, end);
+      bool negative = p != end && *p == '-';
+      p += (p != end && (*p == '-' || *p == '+'));
+      const char * digits = p;
+      long long res = 0;
+      const long long limit = static_cast< long long >(std::numeric_limits< int >::max()) + 1;
+      while (p != end && *p >= '0' && *p <= '9') {
+        res = std::min(res * 10 + (*p - '0'), limit + 1);
+        ++p;
+      }
+      if (p == digits || (p != end && !isBlank(*p)) || res > limit || (res == limit && !negative)) {
+        return nullptr;
+      }
+      value = static_cast< int >(negative ? -res : res);
+      return p;
+    }
+
+    const char * parseSize(const char * p, const char * end, size_t & value)
+    {
+      p = skipBlanks(p, end);
+      const char * digits = p;
+      size_t res = 0;
+      while (p != end && *p >= '0' && *p <= '9') {
+        res = res * 10 + (*p - '0');
+        ++p;
+      }
+      if (p == digits) {
+        return nullptr;
+      }
+      value = res;
+      return p;
+    }
+
+    template< class T >
+    bool readPod(std::istream & in, T & value)
+    {
+      return static_cast< bool >(in.read(reinterpret_cast< char * >(&value), sizeof(T)));
+    }
+
+    template< class T >
+    void writePod(std::ostream & out, const T & value)
+    {
+      out.write(reinterpret_cast< const char * >(&value), sizeof(T));
+    }
+
+    size_t bytesLeft(std::istream & in)
+    {
+      std::streamoff pos = in.tellg();
+      in.seekg(0, std::ios::end);
+      std::streamoff end = in.tellg();
+      in.seekg(pos);
+      return (pos < 0 || end < pos) ? 0 : static_cast< size_t >(end - pos);
+    }
+
+    bool readOffsets(std::istream & in, std::vector< size_t > & offsets, size_t count, size_t limit)
+    {
+      uint64_t stored = 0;
+      if (!readPod(in, stored) || stored != count || count > bytesLeft(in) / sizeof(uint64_t)) {
+        return false;
+      }
+      std::vector< uint64_t > raw(count);
+      if (count && !in.read(reinterpret_cast< char * >(raw.data()), sizeof(uint64_t) * count)) {
+        return false;
+      }
+      offsets.assign(raw.begin(), raw.end());
+      return std::all_of(offsets.begin(), offsets.end(), [limit](size_t off) {
+        return off < limit;
+      });
+    }
+
+    void writeOffsets(std::ostream & out, const std::vector< size_t > & offsets)
+    {
+      writePod(out, static_cast< uint64_t >(offsets.size()));
+      std::vector< uint64_t > raw(offsets.begin(), offsets.end());
+      out.write(reinterpret_cast< const char * >(raw.data()), sizeof(uint64_t) * raw.size());
+    }
+  }
+}
+
+chernov::MappedFile::MappedFile(const char * path):
+  data_(nullptr),
+  size_(0),
+  mtime_(0),
+  open_(false)
+{
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) == 0) {
+    size_ = static_cast< size_t >(st.st_size);
+    mtime_ = static_cast< long long >(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    void * p = size_ ? ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    open_ = size_ == 0 || p != MAP_FAILED;
+    data_ = open_ ? static_cast< const char * >(p) : nullptr;
+    if (open_ && size_) {
+      ::madvise(p, size_, MADV_SEQUENTIAL);
+    }
+  }
+  ::close(fd);
+}
+
+chernov::MappedFile::~MappedFile()
+{
+  if (data_) {
+    ::munmap(const_cast< char * >(data_), size_);
+  }
+}
+
+bool chernov::MappedFile::isOpen() const
+{
+  return open_;
+}
+
+const char * chernov::MappedFile::data() const
+{
+  return data_;
+}
+
+size_t chernov::MappedFile::size() const
+{
+  return size_;
+}
+
+long long chernov::MappedFile::mtime() const
+{
+  return mtime_;
+}
+
+bool chernov::buildRowIndex(const char * data, size_t size, size_t stride, RowIndex & index)
+{
+  const char * end = data + size;
+  size_t rows = 0, cols = 0;
+  const char * p = data ? parseSize(data, end, rows) : nullptr;
+  p = p ? parseSize(p, end, cols) : nullptr;
+  if (!p) {
+    return false;
+  }
+  stride = std::max< size_t >(stride, 1);
+  const size_t total = rows * cols;
+  RowIndex res{rows, cols, stride, size, 0, {}, {}};
+  res.rowStart.reserve(rows);
+  res.checkpoints.reserve(total / stride + 1);
+
+  size_t token = 0, col = 0, next_checkpoint = 0;
+  auto record = [&](size_t pos) {
+    if (col == 0) {
+      res.rowStart.push_back(pos);
+    }
+    if (token == next_checkpoint) {
+      res.checkpoints.push_back(pos);
+      next_checkpoint += stride;
+    }
+    ++token;
+    col = col + 1 == cols ? 0 : col + 1;
+  };
+  size_t pos = p - data;
+  unsigned blank = 1;
+  for (; pos + BLOCK <= size && token < total; pos += BLOCK) {
+    unsigned mask = blankMask(data + pos);
+    unsigned starts = ~mask & ((mask << 1) | blank) & 0xFFFF;
+    blank = (mask >> (BLOCK - 1)) & 1;
+    for (; starts && token < total; starts &= starts - 1) {
+      record(pos + __builtin_ctz(starts));
+    }
+  }
+  for (; pos < size && token < total; ++pos) {
+    unsigned now_blank = isBlank(data[pos]);
+    if (blank && !now_blank) {
+      record(pos);
+    }
+    blank = now_blank;
+  }
+  if (token != total) {
+    return false;
+  }
+  index = std::move(res);
+  return true;
+}
+
+bool chernov::loadRowIndex(const char * path, RowIndex & index)
+{
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(INDEX_MAGIC)] = {};
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0) {
+    return false;
+  }
+  uint64_t rows = 0, cols = 0, stride = 0, file_size = 0;
+  int64_t file_time = 0;
+  if (!readPod(in, rows) || !readPod(in, cols) || !readPod(in, stride) || !readPod(in, file_size)) {
+    return false;
+  }
+  if (!readPod(in, file_time) || stride == 0) {
+    return false;
+  }
+  // every value of the indexed text is at least one digit and a blank
+  if (cols && rows > (file_size / 2 + 1) / cols) {
+    return false;
+  }
+  RowIndex res{rows, cols, stride, file_size, file_time, {}, {}};
+  size_t total = res.rows * res.cols;
+  size_t checkpoints = total ? (total - 1) / res.stride + 1 : 0;
+  if (!readOffsets(in, res.rowStart, total ? res.rows : 0, res.fileSize)) {
+    return false;
+  }
+  if (!readOffsets(in, res.checkpoints, checkpoints, res.fileSize)) {
+    return false;
+  }
+  index = std::move(res);
+  return true;
+}
+
+bool chernov::saveRowIndex(const char * path, const RowIndex & index)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  writePod(out, static_cast< uint64_t >(index.rows));
+  writePod(out, static_cast< uint64_t >(index.cols));
+  writePod(out, static_cast< uint64_t >(index.stride));
+  writePod(out, static_cast< uint64_t >(index.fileSize));
+  writePod(out, static_cast< int64_t >(index.fileTime));
+  writeOffsets(out, index.rowStart);
+  writeOffsets(out, index.checkpoints);
+  return static_cast< bool >(out);
+}
+
+size_t chernov::findToken(const char * data, size_t size, const RowIndex & index, size_t token)
+{
+  size_t row = token / index.cols;
+  size_t checkpoint = token / index.stride;
+  size_t from = checkpoint * index.stride;
+  size_t pos = index.checkpoints[checkpoint];
+  if (index.rowStart[row] > pos) {
+    from = row * index.cols;
+    pos = index.rowStart[row];
+  }
+  return skipTokens(data + pos, data + size, token - from) - data;
+}
+
+bool chernov::parseTokens(const char * data, size_t size, const RowIndex & index, size_t begin, size_t end, int * mtx)
+{
+  if (begin >= end) {
+    return true;
+  }
+  const char * p = data + findToken(data, size, index, begin);
+  const char * last = data + size;
+  for (size_t i = begin; p && i < end; ++i) {
+    p = parseInt(p, last, mtx[i]);
+  }
+  return p != nullptr;
+}
+
+bool chernov::loadMatrixParallel(const char * data, size_t size, const RowIndex & index, int * mtx, size_t threads)
+{
+  const size_t total = index.rows * index.cols;
+  threads = std::max< size_t >(1, std::min(threads, total / index.stride + 1));
+  std::vector< char > ok(threads, 0);
+  std::vector< std::thread > workers;
+  auto work = [&](size_t t) {
+    ok[t] = parseTokens(data, size, index, total * t / threads, total * (t + 1) / threads, mtx);
+  };
+  size_t started = 1;
+  try {
+    for (; started < threads; ++started) {
+      workers.emplace_back(work, started);
+    }
+  } catch (const std::system_error &) {
+  }
+  work(0);
+  for (size_t t = started; t < threads; ++t) {
+    work(t);
+  }
+  for (std::thread & w: workers) {
+    w.join();
+  }
+  return std::all_of(ok.begin(), ok.end(), [](char v) {
+    return v != 0;
+  });
+}
@@ -0,0 +1,53 @@
+#ifndef CHERNOV_ROW_INDEX_HPP
+#define CHERNOV_ROW_INDEX_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace chernov {
+  class MappedFile {
+  public:
+    explicit MappedFile(const char * path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    bool isOpen() const;
+    const char * data() const;
+    size_t size() const;
+    long long mtime() const;
+
+  private:
+    const char * data_;
+    size_t size_;
+    long long mtime_;
+    bool open_;
+  };
+
+  // Byte offsets into a "rows cols v..." text: the first value of every
+  // row and every stride-th value, so any run of values can be parsed
+  // without reading what precedes it.
+  struct RowIndex {
+    size_t rows;
+    size_t cols;
+    size_t stride;
+    size_t fileSize;
+    long long fileTime;
+    std::vector< size_t > rowStart;
+    std::vector< size_t > checkpoints;
+  };
+
+  bool buildRowIndex(const char * data, size_t size, size_t stride, RowIndex & index);
+  bool loadRowIndex(const char * path, RowIndex & index);
+  bool saveRowIndex(const char * path, const RowIndex & index);
+
+  size_t findToken(const char * data, size_t size, const RowIndex & index, size_t token);
+  bool parseTokens(const char * data, size_t size, const RowIndex & index, size_t begin, size_t end, int * mtx);
+
+  // Splits the values, not the rows, evenly across threads; each thread
+  // starts from the nearest checkpoint, so a few very wide rows still
+  // spread over all of them.
+  bool loadMatrixParallel(const char * data, size_t size, const RowIndex & index, int * mtx, size_t threads);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+#include "matrix.hpp"
+
+namespace goltsov
+{
+  namespace
+  {
+    bool checkMtx(const long long * mtx, size_t stride, size_t rows, size_t cols)
+    {
+      return rows == 0 || cols == 0 || (mtx != nullptr && stride >= cols);
+    }
+  }
+}
+
+unsigned goltsov_capiVersion(void)
+{
+  return GOLTSOV_CAPI_VERSION;
+}
+
+int goltsov_lwrTriMtx(const long long * mtx, size_t stride, size_t rows, size_t cols, int * result)
+{
+  if (!goltsov::checkMtx(mtx, stride, rows, cols) || result == nullptr)
+  {
+    return GOLTSOV_EINVAL;
+  }
+  // lwrTriMtx only uses its cols argument as the row pitch
+  if (rows < cols)
+  {
+    *result = goltsov::lwrTriMtx(mtx, rows, cols - rows, stride, 0, 1);
+  }
+  else
+  {
+    *result = goltsov::lwrTriMtx(mtx, cols, rows - cols, stride, 1, 0);
+  }
+  return GOLTSOV_OK;
+}
+
+int goltsov_cntLocMax(const long long * mtx, size_t stride, size_t rows, size_t cols, size_t * result)
+{
+  if (!goltsov::checkMtx(mtx, stride, rows, cols) || result == nullptr)
+  {
+    return GOLTSOV_EINVAL;
+  }
+  if (stride == cols || rows == 0 || cols == 0)
+  {
+    *result = goltsov::cntLocMax(mtx, rows, cols);
+    return GOLTSOV_OK;
+  }
+  try
+  {
+    std::vector< long long > dense(rows * cols);
+    for (size_t i = 0; i < rows; ++i)
+    {
+      std::copy(mtx + i * stride, mtx + i * stride + cols, dense.data() + i * cols);
+    }
+    *result = goltsov::cntLocMax(dense.data(), rows, cols);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return GOLTSOV_ENOMEM;
+  }
+  return GOLTSOV_OK;
+}
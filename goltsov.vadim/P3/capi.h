@@ -0,0 +1,34 @@
+#ifndef GOLTSOV_CAPI_H
+#define GOLTSOV_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define GOLTSOV_CAPI_VERSION 1
+
+#define GOLTSOV_OK 0
+#define GOLTSOV_EINVAL 1
+#define GOLTSOV_ENOMEM 3
+
+/*
+ * The matrix is rows x cols, row-major, with stride elements between the
+ * first cells of neighbouring rows (stride >= cols). Memory stays owned by
+ * the caller and is only read.
+ */
+
+unsigned goltsov_capiVersion(void);
+
+/* *result is 1 when some square window along the longer side is lower triangular */
+int goltsov_lwrTriMtx(const long long * mtx, size_t stride, size_t rows, size_t cols, int * result);
+
+int goltsov_cntLocMax(const long long * mtx, size_t stride, size_t rows, size_t cols, size_t * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+#include "extrema.hpp"
+#include <cstring>
+
+namespace goltsov
+{
+  namespace
+  {
+    const char * const CLASS_NAMES[EXTREMA_CLASSES] = {"max", "min", "weakmax", "weakmin", "saddle"};
+    const int RING_I[8] = {-1, -1, -1, 0, 1, 1, 1, 0};
+    const int RING_J[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+    const unsigned CROSS = 0xAA;
+    const unsigned RING = 0xFF;
+
+    size_t signChanges(unsigned gt, unsigned lt, unsigned ring)
+    {
+      int first = 0;
+      int last = 0;
+      size_t changes = 0;
+      for (size_t k = 0; k < 8; ++k)
+      {
+        if (!(ring & (1u << k)))
+        {
+          continue;
+        }
+        int sign = (gt & (1u << k)) ? 1 : (lt & (1u << k)) ? -1 : 0;
+        if (sign == 0)
+        {
+          continue;
+        }
+        if (first == 0)
+        {
+          first = sign;
+        }
+        else if (sign != last)
+        {
+          ++changes;
+        }
+        last = sign;
+      }
+      return changes + (first != 0 && first != last);
+    }
+  }
+}
+
+unsigned goltsov::parseExtremaClasses(const char * list)
+{
+  if (list == nullptr || *list == '\0')
+  {
+    return (1u << EXTREMA_CLASSES) - 1;
+  }
+  unsigned res = 0;
+  while (*list)
+  {
+    size_t len = std::strcspn(list, ",");
+    for (size_t c = 0; c < EXTREMA_CLASSES; ++c)
+    {
+      if (std::strlen(CLASS_NAMES[c]) == len && std::strncmp(CLASS_NAMES[c], list, len) == 0)
+      {
+        res |= 1u << c;
+      }
+    }
+    list += len + (list[len] == ',');
+  }
+  return res;
+}
+
+void goltsov::classifyExtrema(const long long * mtx, size_t rows, size_t cols, unsigned classes, bool coords, ExtremaReport & report)
+{
+  for (size_t n = 0; n < 2; ++n)
+  {
+    for (size_t c = 0; c < EXTREMA_CLASSES; ++c)
+    {
+      report.counts[n][c] = 0;
+      report.coords[n][c].clear();
+    }
+  }
+  if (rows <= 2 || cols <= 2)
+  {
+    return;
+  }
+
+  for (size_t i = 1; i < rows - 1; ++i)
+  {
+    for (size_t j = 1; j < cols - 1; ++j)
+    {
+      long long center = mtx[i * cols + j];
+      unsigned gt = 0;
+      unsigned lt = 0;
+      for (size_t k = 0; k < 8; ++k)
+      {
+        long long other = mtx[(i + RING_I[k]) * cols + j + RING_J[k]];
+        gt |= static_cast< unsigned >(center > other) << k;
+        lt |= static_cast< unsigned >(center < other) << k;
+      }
+
+      const unsigned masks[2] = {CROSS, RING};
+      for (size_t n = 0; n < 2; ++n)
+      {
+        unsigned m = masks[n];
+        bool is[EXTREMA_CLASSES] = {};
+        is[STRICT_MAX] = (gt & m) == m;
+        is[STRICT_MIN] = (lt & m) == m;
+        is[WEAK_MAX] = (lt & m) == 0;
+        is[WEAK_MIN] = (gt & m) == 0;
+        is[SADDLE] = (classes & (1u << SADDLE)) && signChanges(gt, lt, m) >= 4;
+        for (size_t c = 0; c < EXTREMA_CLASSES; ++c)
+        {
+          if (is[c] && (classes & (1u << c)))
+          {
+            ++report.counts[n][c];
+            if (coords)
+            {
+              report.coords[n][c].emplace_back(i, j);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+std::ostream & goltsov::printExtrema(std::ostream & output, const ExtremaReport & report, unsigned classes, bool coords)
+{
+  const int neighbours[2] = {4, 8};
+  for (size_t n = 0; n < 2; ++n)
+  {
+    for (size_t c = 0; c < EXTREMA_CLASSES; ++c)
+    {
+      if (!(classes & (1u << c)))
+      {
+        continue;
+      }
+      output << neighbours[n] << ' ' << CLASS_NAMES[c] << ' ' << report.counts[n][c];
+      if (coords)
+      {
+        for (const std::pair< size_t, size_t > & p: report.coords[n][c])
+        {
+          output << ' ' << p.first << ':' << p.second;
+        }
+      }
+      output << '\n';
+    }
+  }
+  return output;
+}
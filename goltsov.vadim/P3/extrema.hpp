@@ -0,0 +1,32 @@
+#ifndef GOLTSOV_EXTREMA_HPP
+#define GOLTSOV_EXTREMA_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace goltsov
+{
+  enum ExtremaClass
+  {
+    STRICT_MAX,
+    STRICT_MIN,
+    WEAK_MAX,
+    WEAK_MIN,
+    SADDLE,
+    EXTREMA_CLASSES
+  };
+
+  struct ExtremaReport
+  {
+    size_t counts[2][EXTREMA_CLASSES];
+    std::vector< std::pair< size_t, size_t > > coords[2][EXTREMA_CLASSES];
+  };
+
+  unsigned parseExtremaClasses(const char * list);
+  void classifyExtrema(const long long * mtx, size_t rows, size_t cols, unsigned classes, bool coords, ExtremaReport & report);
+  std::ostream & printExtrema(std::ostream & output, const ExtremaReport & report, unsigned classes, bool coords);
+}
+
+#endif
@@ -1,13 +1,18 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include "extrema.hpp"
+#include "matrix.hpp"
+#include "stream.hpp"
+#include "triangle.hpp"
 
 namespace goltsov
 {
   long long * create(size_t rows, size_t cols);
   std::istream & getMtx(long long * mtx, size_t rows, size_t cols, std::istream & input);
-  bool lwrTriMtx(const long long * mtx, size_t n, size_t shift, size_t cols, size_t flag1, size_t flag2);
-  size_t cntLocMax(const long long * mtx, size_t rows, size_t cols);
 }
 
 int main(int argc, char ** argv)
@@ -56,6 +61,34 @@ int main(int argc, char ** argv)
     return 2;
   }
 
+  if (std::getenv("GOLTSOV_STREAM"))
+  {
+    goltsov::MatrixStream stream;
+    try
+    {
+      goltsov::initStream(stream, rows, cols);
+    }
+    catch (const std::bad_alloc &)
+    {
+      std::cerr << "Bad alloc" << '\n';
+      return 3;
+    }
+    catch (const std::length_error &)
+    {
+      std::cerr << "Bad alloc" << '\n';
+      return 3;
+    }
+    if (!goltsov::streamMtx(stream, input))
+    {
+      std::cerr << "Bad input\n";
+      return 2;
+    }
+    std::ofstream output(argv[3]);
+    output << stream.lwrTri << '\n';
+    output << stream.locMax << '\n';
+    return 0;
+  }
+
   long long * mtx = nullptr;
 
   if (num == 1)
@@ -87,8 +120,33 @@ int main(int argc, char ** argv)
   }
 
   bool answer1;
+  const char * windowsPath = std::getenv("GOLTSOV_WINDOWS");
 
-  if (rows < cols)
+  if (windowsPath)
+  {
+    goltsov::TriangleIndex index;
+    goltsov::buildTriangleIndex(mtx, rows, cols, index);
+    if (rows < cols)
+    {
+      answer1 = goltsov::lwrTriShift(index, rows, cols - rows, 0, 1);
+    }
+    else
+    {
+      answer1 = goltsov::lwrTriShift(index, cols, rows - cols, 1, 0);
+    }
+    std::ifstream queries(windowsPath);
+    const char * answersPath = std::getenv("GOLTSOV_WINDOWS_OUT");
+    if (answersPath)
+    {
+      std::ofstream answers(answersPath);
+      goltsov::answerWindows(queries, answers, index);
+    }
+    else
+    {
+      goltsov::answerWindows(queries, std::cout, index);
+    }
+  }
+  else if (rows < cols)
   {
     answer1 = goltsov::lwrTriMtx(mtx, rows, cols - rows, cols, 0, 1);
   }
@@ -97,73 +155,32 @@ int main(int argc, char ** argv)
     answer1 = goltsov::lwrTriMtx(mtx, cols, rows - cols, cols, 1, 0);
   }
 
-  size_t answer2 = goltsov::cntLocMax(mtx, rows, cols);
+  size_t answer2 = 0;
+  const char * extremaPath = std::getenv("GOLTSOV_EXTREMA");
 
-  std::ofstream output(argv[3]);
-  output << answer1 << '\n';
-  output << answer2 << '\n';
-
-  if (num == 2)
-  {
-    free(mtx);
-  }
-}
-
-bool goltsov::lwrTriMtx(const long long * mtx, size_t n, size_t shift, size_t cols, size_t flag1, size_t flag2)
-{
-  if (n == 0)
+  if (extremaPath)
   {
-    return true;
+    unsigned classes = goltsov::parseExtremaClasses(std::getenv("GOLTSOV_EXTREMA_CLASSES"));
+    bool coords = std::getenv("GOLTSOV_EXTREMA_COORDS") != nullptr;
+    goltsov::ExtremaReport report;
+    goltsov::classifyExtrema(mtx, rows, cols, classes | (1u << goltsov::STRICT_MAX), coords, report);
+    answer2 = report.counts[0][goltsov::STRICT_MAX];
+    std::ofstream extremaOutput(extremaPath);
+    goltsov::printExtrema(extremaOutput, report, classes, coords);
   }
-
-  for (size_t sh = 0; sh <= shift; ++sh)
+  else
   {
-    bool flag = false;
-
-    for (size_t i = 0; i < n - 1 && !flag; ++i)
-    {
-      for (size_t j = i + 1; j < n; ++j)
-      {
-        if (mtx[(i + sh * flag1) * cols + j + sh * flag2])
-        {
-          flag = true;
-          break;
-        }
-      }
-    }
-
-    if (!flag)
-    {
-      return true;
-    }
+    answer2 = goltsov::cntLocMax(mtx, rows, cols);
   }
 
-  return false;
-}
-
-size_t goltsov::cntLocMax(const long long * mtx, size_t rows, size_t cols)
-{
-  size_t answer = 0;
-  if (rows <= 2 || cols <= 2)
-  {
-    return 0;
-  }
+  std::ofstream output(argv[3]);
+  output << answer1 << '\n';
+  output << answer2 << '\n';
 
-  for (size_t i = 1; i < rows - 1; ++i)
+  if (num == 2)
   {
-    for (size_t j = 1; j < cols - 1; ++j)
-    {
-      if (mtx[i * cols + j] > mtx[(i - 1) * cols + j] && mtx[i * cols + j] > mtx[(i + 1) * cols + j])
-      {
-        if (mtx[i * cols + j] > mtx[i * cols + j - 1] && mtx[i * cols + j] > mtx[i * cols + j + 1])
-        {
-          ++answer;
-        }
-      }
-    }
+    free(mtx);
   }
-
-  return answer;
 }
 
 long long * goltsov::create(size_t rows, size_t cols)
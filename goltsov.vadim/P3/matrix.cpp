@@ -0,0 +1,58 @@
+#include "matrix.hpp"
+
+bool goltsov::lwrTriMtx(const long long * mtx, size_t n, size_t shift, size_t cols, size_t flag1, size_t flag2)
+{
+  if (n == 0)
+  {
+    return true;
+  }
+
+  for (size_t sh = 0; sh <= shift; ++sh)
+  {
+    bool flag = false;
+
+    for (size_t i = 0; i < n - 1 && !flag; ++i)
+    {
+      for (size_t j = i + 1; j < n; ++j)
+      {
+        if (mtx[(i + sh * flag1) * cols + j + sh * flag2])
+        {
+          flag = true;
+          break;
+        }
+      }
+    }
+
+    if (!flag)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+size_t goltsov::cntLocMax(const long long * mtx, size_t rows, size_t cols)
+{
+  size_t answer = 0;
+  if (rows <= 2 || cols <= 2)
+  {
+    return 0;
+  }
+
+  for (size_t i = 1; i < rows - 1; ++i)
+  {
+    for (size_t j = 1; j < cols - 1; ++j)
+    {
+      if (mtx[i * cols + j] > mtx[(i - 1) * cols + j] && mtx[i * cols + j] > mtx[(i + 1) * cols + j])
+      {
+        if (mtx[i * cols + j] > mtx[i * cols + j - 1] && mtx[i * cols + j] > mtx[i * cols + j + 1])
+        {
+          ++answer;
+        }
+      }
+    }
+  }
+
+  return answer;
+}
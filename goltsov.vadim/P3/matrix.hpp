@@ -0,0 +1,12 @@
+#ifndef GOLTSOV_MATRIX_HPP
+#define GOLTSOV_MATRIX_HPP
+
+#include <cstddef>
+
+namespace goltsov
+{
+  bool lwrTriMtx(const long long * mtx, size_t n, size_t shift, size_t cols, size_t flag1, size_t flag2);
+  size_t cntLocMax(const long long * mtx, size_t rows, size_t cols);
+}
+
+#endif
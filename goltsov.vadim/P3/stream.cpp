@@ -0,0 +1,161 @@
+#include "stream.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace goltsov
+{
+  namespace
+  {
+    long long lastNonZero(const long long * row, size_t cols)
+    {
+      for (size_t j = cols; j > 0; --j)
+      {
+        if (row[j - 1])
+        {
+          return static_cast< long long >(j - 1);
+        }
+      }
+      return -1;
+    }
+
+    // Tall matrix: the square at shift sh holds rows sh..sh+n-1, and it is
+    // lower triangular when R(r) - r <= -sh for its first n - 1 rows, where
+    // R(r) is the last non-zero column. A monotone deque keeps the maximum
+    // of R(r) - r over the last n - 1 rows.
+    void pushTallRow(MatrixStream & stream, const long long * row)
+    {
+      const size_t n = stream.cols;
+      const size_t r = stream.row;
+      const long long extent = lastNonZero(row, stream.cols) - static_cast< long long >(r);
+      while (!stream.extents.empty() && stream.extents.back().second <= extent)
+      {
+        stream.extents.pop_back();
+      }
+      stream.extents.emplace_back(r, extent);
+      if (r + 2 < n)
+      {
+        return;
+      }
+      const size_t sh = r + 2 - n;
+      while (stream.extents.front().first < sh)
+      {
+        stream.extents.pop_front();
+      }
+      if (sh <= stream.rows - n && stream.extents.front().second <= -static_cast< long long >(sh))
+      {
+        stream.lwrTri = true;
+      }
+    }
+
+    // Wide matrix: the square at shift sh holds columns sh..sh+n-1, and row
+    // i rules it out when columns sh+i+1..sh+n-1 have a non-zero value.
+    void pushWideRow(MatrixStream & stream, const long long * row)
+    {
+      const size_t n = stream.rows;
+      const size_t i = stream.row;
+      if (i + 1 >= n)
+      {
+        return;
+      }
+      for (size_t j = 0; j < stream.cols; ++j)
+      {
+        stream.nonZero[j + 1] = stream.nonZero[j] + (row[j] != 0);
+      }
+      for (size_t sh = 0; sh < stream.validShift.size(); ++sh)
+      {
+        if (stream.nonZero[sh + n] != stream.nonZero[sh + i + 1])
+        {
+          stream.validShift[sh] = 0;
+        }
+      }
+    }
+
+    bool isLocMax(const long long * up, const long long * mid, const long long * down, size_t j)
+    {
+      return mid[j] > up[j] && mid[j] > down[j] && mid[j] > mid[j - 1] && mid[j] > mid[j + 1];
+    }
+  }
+}
+
+void goltsov::initStream(MatrixStream & stream, size_t rows, size_t cols)
+{
+  stream.rows = rows;
+  stream.cols = cols;
+  stream.row = 0;
+  if (cols > stream.window.max_size() / 3)
+  {
+    throw std::length_error("Stream window is too large");
+  }
+  stream.window.assign(3 * cols, 0);
+  stream.extents.clear();
+  stream.validShift.clear();
+  stream.nonZero.clear();
+  if (rows < cols)
+  {
+    stream.validShift.assign(cols - rows + 1, 1);
+    stream.nonZero.assign(cols + 1, 0);
+  }
+  stream.lwrTri = std::min(rows, cols) <= 1;
+  stream.locMax = 0;
+}
+
+long long * goltsov::nextRow(MatrixStream & stream)
+{
+  return stream.window.data() + (stream.row % 3) * stream.cols;
+}
+
+void goltsov::pushRow(MatrixStream & stream)
+{
+  const long long * row = nextRow(stream);
+  if (!stream.lwrTri && stream.rows >= stream.cols)
+  {
+    pushTallRow(stream, row);
+  }
+  else if (!stream.lwrTri)
+  {
+    pushWideRow(stream, row);
+  }
+
+  if (stream.row >= 2 && stream.cols > 2)
+  {
+    const long long * up = stream.window.data() + ((stream.row - 2) % 3) * stream.cols;
+    const long long * mid = stream.window.data() + ((stream.row - 1) % 3) * stream.cols;
+    for (size_t j = 1; j < stream.cols - 1; ++j)
+    {
+      stream.locMax += isLocMax(up, mid, row, j);
+    }
+  }
+  ++stream.row;
+}
+
+bool goltsov::finishStream(MatrixStream & stream)
+{
+  if (!stream.lwrTri && stream.rows < stream.cols)
+  {
+    stream.lwrTri = std::find(stream.validShift.begin(), stream.validShift.end(), 1) != stream.validShift.end();
+  }
+  return stream.lwrTri;
+}
+
+std::istream & goltsov::streamMtx(MatrixStream & stream, std::istream & input)
+{
+  if (stream.rows == 0 || stream.cols == 0)
+  {
+    return input;
+  }
+
+  for (size_t i = 0; i < stream.rows && input; ++i)
+  {
+    long long * row = nextRow(stream);
+    for (size_t j = 0; j < stream.cols; ++j)
+    {
+      input >> row[j];
+    }
+    if (input)
+    {
+      pushRow(stream);
+    }
+  }
+  finishStream(stream);
+  return input;
+}
@@ -0,0 +1,35 @@
+#ifndef GOLTSOV_STREAM_HPP
+#define GOLTSOV_STREAM_HPP
+
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <utility>
+#include <vector>
+
+namespace goltsov
+{
+  // Answers of lwrTriMtx and cntLocMax updated one row at a time. Only the
+  // last three rows and O(cols) shift state are kept, so the number of rows
+  // does not change the memory used.
+  struct MatrixStream
+  {
+    size_t rows;
+    size_t cols;
+    size_t row;
+    std::vector< long long > window;
+    std::deque< std::pair< size_t, long long > > extents;
+    std::vector< char > validShift;
+    std::vector< size_t > nonZero;
+    bool lwrTri;
+    size_t locMax;
+  };
+
+  void initStream(MatrixStream & stream, size_t rows, size_t cols);
+  long long * nextRow(MatrixStream & stream);
+  void pushRow(MatrixStream & stream);
+  bool finishStream(MatrixStream & stream);
+  std::istream & streamMtx(MatrixStream & stream, std::istream & input);
+}
+
+#endif
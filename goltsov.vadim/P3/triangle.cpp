@@ -0,0 +1,173 @@
+#include "triangle.hpp"
+#include <algorithm>
+#include <string>
+
+namespace goltsov
+{
+  namespace
+  {
+    size_t floorLog2(size_t n)
+    {
+      size_t res = 0;
+      while (n >>= 1)
+      {
+        ++res;
+      }
+      return res;
+    }
+
+    size_t diagonal(const TriangleIndex & index, size_t row, size_t col)
+    {
+      return col + index.rows - 1 - row;
+    }
+
+    size_t diagLength(const TriangleIndex & index, size_t d)
+    {
+      return index.diagStart[d + 1] - index.diagStart[d];
+    }
+
+    template< class T, class F >
+    void buildLevels(std::vector< std::vector< T > > & levels, const TriangleIndex & index, size_t depth, F pick)
+    {
+      for (size_t l = 1; l < depth; ++l)
+      {
+        const std::vector< T > & prev = levels[l - 1];
+        std::vector< T > next(prev.size());
+        const size_t half = size_t(1) << (l - 1);
+        for (size_t d = 0; d + 1 < index.diagStart.size(); ++d)
+        {
+          const size_t start = index.diagStart[d];
+          const size_t len = diagLength(index, d);
+          for (size_t p = 0; p + 2 * half <= len; ++p)
+          {
+            next[start + p] = pick(prev[start + p], prev[start + p + half]);
+          }
+        }
+        levels.push_back(std::move(next));
+      }
+    }
+
+    template< class T, class F >
+    T queryLevels(const std::vector< std::vector< T > > & levels, size_t start, size_t begin, size_t end, F pick)
+    {
+      const size_t l = floorLog2(end - begin);
+      return pick(levels[l][start + begin], levels[l][start + end - (size_t(1) << l)]);
+    }
+  }
+}
+
+void goltsov::buildTriangleIndex(const long long * mtx, size_t rows, size_t cols, TriangleIndex & index)
+{
+  index.rows = rows;
+  index.cols = cols;
+  index.diagStart.assign(1, 0);
+  index.nextMin.clear();
+  index.prevMax.clear();
+  if (rows == 0 || cols == 0)
+  {
+    return;
+  }
+
+  for (size_t d = 0; d < rows + cols - 1; ++d)
+  {
+    size_t row = d < rows ? rows - 1 - d : 0;
+    size_t col = d < rows ? 0 : d - rows + 1;
+    index.diagStart.push_back(index.diagStart.back() + std::min(rows - row, cols - col));
+  }
+
+  std::vector< uint32_t > next(rows * cols);
+  std::vector< int32_t > prev(rows * cols);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    const long long * row = mtx + i * cols;
+    uint32_t right = static_cast< uint32_t >(cols);
+    int32_t left = -1;
+    for (size_t j = 0; j < cols; ++j)
+    {
+      left = row[j] ? static_cast< int32_t >(j) : left;
+      prev[index.diagStart[diagonal(index, i, j)] + std::min(i, j)] = left;
+      size_t back = cols - 1 - j;
+      right = row[back] ? static_cast< uint32_t >(back) : right;
+      next[index.diagStart[diagonal(index, i, back)] + std::min(i, back)] = right;
+    }
+  }
+
+  const size_t depth = floorLog2(std::min(rows, cols)) + 1;
+  index.nextMin.push_back(std::move(next));
+  index.prevMax.push_back(std::move(prev));
+  buildLevels(index.nextMin, index, depth, [](uint32_t a, uint32_t b)
+  {
+    return std::min(a, b);
+  });
+  buildLevels(index.prevMax, index, depth, [](int32_t a, int32_t b)
+  {
+    return std::max(a, b);
+  });
+}
+
+bool goltsov::isLowerWindow(const TriangleIndex & index, size_t row, size_t col, size_t size)
+{
+  if (size <= 1)
+  {
+    return true;
+  }
+  const size_t d = diagonal(index, row, col + 1);
+  const size_t p = std::min(row, col + 1);
+  uint32_t first = queryLevels(index.nextMin, index.diagStart[d], p, p + size - 1, [](uint32_t a, uint32_t b)
+  {
+    return std::min(a, b);
+  });
+  return first >= col + size;
+}
+
+bool goltsov::isUpperWindow(const TriangleIndex & index, size_t row, size_t col, size_t size)
+{
+  if (size <= 1)
+  {
+    return true;
+  }
+  const size_t d = diagonal(index, row + 1, col);
+  const size_t p = std::min(row + 1, col);
+  int32_t last = queryLevels(index.prevMax, index.diagStart[d], p, p + size - 1, [](int32_t a, int32_t b)
+  {
+    return std::max(a, b);
+  });
+  return last < static_cast< long long >(col);
+}
+
+bool goltsov::lwrTriShift(const TriangleIndex & index, size_t n, size_t shift, size_t flag1, size_t flag2)
+{
+  if (n == 0)
+  {
+    return true;
+  }
+
+  for (size_t sh = 0; sh <= shift; ++sh)
+  {
+    if (isLowerWindow(index, sh * flag1, sh * flag2, n))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::ostream & goltsov::answerWindows(std::istream & queries, std::ostream & output, const TriangleIndex & index)
+{
+  std::string kind;
+  size_t row = 0;
+  size_t col = 0;
+  size_t size = 0;
+  while (queries >> kind >> row >> col >> size)
+  {
+    bool inside = row + size <= index.rows && col + size <= index.cols;
+    if (!inside || (kind != "L" && kind != "U"))
+    {
+      output << "-\n";
+      continue;
+    }
+    output << (kind == "L" ? isLowerWindow(index, row, col, size) : isUpperWindow(index, row, col, size)) << '\n';
+  }
+  return output;
+}
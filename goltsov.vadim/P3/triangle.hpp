@@ -0,0 +1,31 @@
+#ifndef GOLTSOV_TRIANGLE_HPP
+#define GOLTSOV_TRIANGLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace goltsov
+{
+  // Per-cell nearest non-zero column to the right (nextCol) and to the left
+  // (prevCol) of every row, stored diagonal by diagonal with sparse tables,
+  // so a square window is checked with one range query along a diagonal.
+  struct TriangleIndex
+  {
+    size_t rows;
+    size_t cols;
+    std::vector< size_t > diagStart;
+    std::vector< std::vector< uint32_t > > nextMin;
+    std::vector< std::vector< int32_t > > prevMax;
+  };
+
+  void buildTriangleIndex(const long long * mtx, size_t rows, size_t cols, TriangleIndex & index);
+  bool isLowerWindow(const TriangleIndex & index, size_t row, size_t col, size_t size);
+  bool isUpperWindow(const TriangleIndex & index, size_t row, size_t col, size_t size);
+  bool lwrTriShift(const TriangleIndex & index, size_t n, size_t shift, size_t flag1, size_t flag2);
+  std::ostream & answerWindows(std::istream & queries, std::ostream & output, const TriangleIndex & index);
+}
+
+#endif
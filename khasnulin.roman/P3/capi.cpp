@@ -0,0 +1,80 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+
+namespace khasnulin
+{
+  namespace
+  {
+    bool isValidMatrix(const int *arr, size_t stride, size_t n, size_t m)
+    {
+      return n == 0 || m == 0 || (arr != nullptr && stride >= m);
+    }
+
+    void copyRows(const int *from, size_t from_stride, size_t n, size_t m, int *to, size_t to_stride)
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        std::copy(from + i * from_stride, from + i * from_stride + m, to + i * to_stride);
+      }
+    }
+  }
+}
+
+unsigned khasnulin_capiVersion(void)
+{
+  return KHASNULIN_CAPI_VERSION;
+}
+
+int khasnulin_lftBotClk(int *arr, size_t stride, size_t n, size_t m)
+{
+  if (!khasnulin::isValidMatrix(arr, stride, n, m))
+  {
+    return KHASNULIN_EINVAL;
+  }
+  try
+  {
+    // lftBotClk stops in the middle of the spiral on overflow, so it always
+    // works on a copy and the caller's buffer is only written on success
+    std::vector< int > dense(n * m);
+    khasnulin::copyRows(arr, stride, n, m, dense.data(), m);
+    khasnulin::lftBotClk(dense.data(), n, m);
+    khasnulin::copyRows(dense.data(), m, n, m, arr, stride);
+  }
+  catch (const std::overflow_error &)
+  {
+    return KHASNULIN_EOVERFLOW;
+  }
+  catch (const std::bad_alloc &)
+  {
+    return KHASNULIN_ENOMEM;
+  }
+  return KHASNULIN_OK;
+}
+
+int khasnulin_lwrTriMtx(const int *arr, size_t stride, size_t n, size_t m, int *result)
+{
+  if (!khasnulin::isValidMatrix(arr, stride, n, m) || result == nullptr)
+  {
+    return KHASNULIN_EINVAL;
+  }
+  try
+  {
+    std::vector< int > dense;
+    if (stride != m)
+    {
+      dense.resize(n * m);
+      khasnulin::copyRows(arr, stride, n, m, dense.data(), m);
+      arr = dense.data();
+    }
+    *result = khasnulin::lwrTriMtx(arr, n, m);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return KHASNULIN_ENOMEM;
+  }
+  return KHASNULIN_OK;
+}
@@ -0,0 +1,35 @@
+#ifndef KHASNULIN_CAPI_H
+#define KHASNULIN_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define KHASNULIN_CAPI_VERSION 1
+
+#define KHASNULIN_OK 0
+#define KHASNULIN_EINVAL 1
+#define KHASNULIN_EOVERFLOW 2
+#define KHASNULIN_ENOMEM 3
+
+/*
+ * Row-major n x m matrices in caller memory. Row i starts at arr + i * stride,
+ * so stride >= m; padding between rows is never read or written.
+ */
+
+unsigned khasnulin_capiVersion(void);
+
+/* Spiral subtraction in place; the matrix is left unchanged on overflow */
+int khasnulin_lftBotClk(int *arr, size_t stride, size_t n, size_t m);
+
+/* *result is 1 when the matrix is lower triangular, 0 otherwise */
+int khasnulin_lwrTriMtx(const int *arr, size_t stride, size_t n, size_t m, int *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
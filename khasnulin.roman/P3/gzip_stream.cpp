@@ -0,0 +1,363 @@
+#include "gzip_stream.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <system_error>
+
+namespace khasnulin
+{
+  namespace
+  {
+    const size_t WINDOW = 32768;
+    const size_t HASH_SIZE = 1 << 15;
+    const size_t MIN_MATCH = 3;
+    const size_t MAX_MATCH = 258;
+    const size_t MAX_CHAIN = 16;
+
+    const uint16_t LENGTH_BASE[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+        99, 115, 131, 163, 195, 227, 258};
+    const uint8_t LENGTH_EXTRA[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const uint16_t DIST_BASE[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025,
+        1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const uint8_t DIST_EXTRA[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12,
+        12, 13, 13};
+
+    struct Crc32Table
+    {
+      uint32_t values[256];
+      Crc32Table()
+      {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+          uint32_t c = i;
+          for (int k = 0; k < 8; k++)
+          {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+          }
+          values[i] = c;
+        }
+      }
+    };
+
+    uint32_t crc32(const char *data, size_t size)
+    {
+      static const Crc32Table table;
+      uint32_t crc = 0xFFFFFFFFu;
+      for (size_t i = 0; i < size; i++)
+      {
+        crc = table.values[(crc ^ static_cast< uint8_t >(data[i])) & 0xFF] ^ (crc >> 8);
+      }
+      return crc ^ 0xFFFFFFFFu;
+    }
+
+    class BitWriter
+    {
+    public:
+      explicit BitWriter(std::string &out):
+        out_(out),
+        bits_(0),
+        count_(0)
+      {}
+
+      void put(uint32_t bits, unsigned n)
+      {
+        bits_ |= static_cast< uint64_t >(bits) << count_;
+        count_ += n;
+        while (count_ >= 8)
+        {
+          out_.push_back(static_cast< char >(bits_ & 0xFF));
+          bits_ >>= 8;
+          count_ -= 8;
+        }
+      }
+
+      void flush()
+      {
+        if (count_ > 0)
+        {
+          out_.push_back(static_cast< char >(bits_ & 0xFF));
+        }
+        bits_ = 0;
+        count_ = 0;
+      }
+
+    private:
+      std::string &out_;
+      uint64_t bits_;
+      unsigned count_;
+    };
+
+    uint32_t reverseBits(uint32_t code, unsigned n)
+    {
+      uint32_t reversed = 0;
+      for (unsigned i = 0; i < n; i++)
+      {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+      }
+      return reversed;
+    }
+
+    struct FixedCodes
+    {
+      uint16_t literal[288];
+      uint8_t literal_bits[288];
+      uint16_t dist[30];
+      FixedCodes()
+      {
+        for (unsigned sym = 0; sym < 288; sym++)
+        {
+          uint32_t code = sym < 144 ? 0x30 + sym : sym < 256 ? 0x190 + sym - 144 : sym < 280 ? sym - 256 : 0xC0 + sym - 280;
+          unsigned bits = sym < 144 ? 8 : sym < 256 ? 9 : sym < 280 ? 7 : 8;
+          literal[sym] = static_cast< uint16_t >(reverseBits(code, bits));
+          literal_bits[sym] = static_cast< uint8_t >(bits);
+        }
+        for (unsigned d = 0; d < 30; d++)
+        {
+          dist[d] = static_cast< uint16_t >(reverseBits(d, 5));
+        }
+      }
+    };
+
+    const FixedCodes &fixedCodes()
+    {
+      static const FixedCodes codes;
+      return codes;
+    }
+
+    void putLiteral(BitWriter &bw, unsigned sym)
+    {
+      const FixedCodes &codes = fixedCodes();
+      bw.put(codes.literal[sym], codes.literal_bits[sym]);
+    }
+
+    void putMatch(BitWriter &bw, size_t length, size_t dist)
+    {
+      size_t lc = std::upper_bound(LENGTH_BASE, LENGTH_BASE + 29, length) - LENGTH_BASE - 1;
+      putLiteral(bw, 257 + lc);
+      bw.put(length - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+      size_t dc = std::upper_bound(DIST_BASE, DIST_BASE + 30, dist) - DIST_BASE - 1;
+      bw.put(fixedCodes().dist[dc], 5);
+      bw.put(dist - DIST_BASE[dc], DIST_EXTRA[dc]);
+    }
+
+    size_t hash3(const uint8_t *p)
+    {
+      return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+    }
+
+    void deflateFixed(std::string &out, const char *data, size_t size)
+    {
+      const uint8_t *src = reinterpret_cast< const uint8_t * >(data);
+      std::vector< int32_t > head(HASH_SIZE, -1);
+      std::vector< int32_t > prev(WINDOW, -1);
+      BitWriter bw(out);
+      bw.put(1, 1);
+      bw.put(1, 2);
+      size_t pos = 0;
+      auto insert = [&](size_t p) {
+        if (p + MIN_MATCH <= size)
+        {
+          size_t h = hash3(src + p);
+          prev[p & (WINDOW - 1)] = head[h];
+          head[h] = static_cast< int32_t >(p);
+        }
+      };
+      while (pos < size)
+      {
+        size_t best_len = 0;
+        size_t best_dist = 0;
+        if (pos + MIN_MATCH <= size)
+        {
+          size_t limit = std::min(MAX_MATCH, size - pos);
+          int32_t cand = head[hash3(src + pos)];
+          for (size_t chain = 0; cand >= 0 && chain < MAX_CHAIN; chain++)
+          {
+            size_t c = static_cast< size_t >(cand);
+            if (c >= pos || pos - c > WINDOW)
+            {
+              break;
+            }
+            size_t len = 0;
+            while (len < limit && src[c + len] == src[pos + len])
+            {
+              len++;
+            }
+            if (len > best_len)
+            {
+              best_len = len;
+              best_dist = pos - c;
+              if (len == limit)
+              {
+                break;
+              }
+            }
+            int32_t next = prev[c & (WINDOW - 1)];
+            if (next >= cand)
+            {
+              break;
+            }
+            cand = next;
+          }
+        }
+        if (best_len >= MIN_MATCH)
+        {
+          putMatch(bw, best_len, best_dist);
+          for (size_t k = 0; k < best_len; k++)
+          {
+            insert(pos + k);
+          }
+          pos += best_len;
+        }
+        else
+        {
+          putLiteral(bw, src[pos]);
+          insert(pos);
+          pos++;
+        }
+      }
+      putLiteral(bw, 256);
+      bw.flush();
+    }
+
+    void putLE32(std::string &out, uint32_t v)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        out.push_back(static_cast< char >((v >> (8 * i)) & 0xFF));
+      }
+    }
+  }
+}
+
+std::string khasnulin::deflateGzipMember(const char *data, size_t size)
+{
+  const char header[] = {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\x03'};
+  std::string out(header, sizeof(header));
+  out.reserve(size / 2 + 64);
+  deflateFixed(out, data, size);
+  putLE32(out, crc32(data, size));
+  putLE32(out, static_cast< uint32_t >(size));
+  return out;
+}
+
+khasnulin::GzipStreamBuf::GzipStreamBuf(std::ostream &sink, size_t threads, size_t block_size):
+  sink_(sink),
+  max_jobs_(2 * std::max< size_t >(threads, 1)),
+  buffer_(std::max< size_t >(block_size, 1)),
+  stop_(false),
+  finished_(false)
+{
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+  try
+  {
+    for (size_t i = 0; i < std::max< size_t >(threads, 1); i++)
+    {
+      workers_.emplace_back(&GzipStreamBuf::work, this);
+    }
+  }
+  catch (const std::system_error &)
+  {
+    if (workers_.empty())
+    {
+      throw;
+    }
+  }
+}
+
+khasnulin::GzipStreamBuf::~GzipStreamBuf()
+{
+  finish();
+}
+
+bool khasnulin::GzipStreamBuf::finish()
+{
+  if (!finished_)
+  {
+    finished_ = true;
+    if (pptr() != pbase() || jobs_.empty())
+    {
+      submit();
+    }
+    while (!jobs_.empty())
+    {
+      writeFront();
+    }
+    {
+      std::lock_guard< std::mutex > lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread &w: workers_)
+    {
+      w.join();
+    }
+    sink_.flush();
+  }
+  return static_cast< bool >(sink_);
+}
+
+khasnulin::GzipStreamBuf::int_type khasnulin::GzipStreamBuf::overflow(int_type ch)
+{
+  if (finished_)
+  {
+    return traits_type::eof();
+  }
+  submit();
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+void khasnulin::GzipStreamBuf::submit()
+{
+  while (jobs_.size() >= max_jobs_)
+  {
+    writeFront();
+  }
+  {
+    std::lock_guard< std::mutex > lock(mutex_);
+    jobs_.push_back(Job{std::string(pbase(), pptr()), std::string(), false});
+    todo_.push_back(&jobs_.back());
+  }
+  work_cv_.notify_one();
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+void khasnulin::GzipStreamBuf::writeFront()
+{
+  std::unique_lock< std::mutex > lock(mutex_);
+  done_cv_.wait(lock, [this]() {
+    return jobs_.front().done;
+  });
+  std::string packed;
+  packed.swap(jobs_.front().packed);
+  jobs_.pop_front();
+  lock.unlock();
+  sink_.write(packed.data(), packed.size());
+}
+
+void khasnulin::GzipStreamBuf::work()
+{
+  std::unique_lock< std::mutex > lock(mutex_);
+  while (true)
+  {
+    work_cv_.wait(lock, [this]() {
+      return stop_ || !todo_.empty();
+    });
+    if (todo_.empty())
+    {
+      return;
+    }
+    Job *job = todo_.front();
+    todo_.pop_front();
+    lock.unlock();
+    std::string packed = deflateGzipMember(job->raw.data(), job->raw.size());
+    lock.lock();
+    job->packed.swap(packed);
+    job->raw.clear();
+    job->done = true;
+    done_cv_.notify_all();
+  }
+}
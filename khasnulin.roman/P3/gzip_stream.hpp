@@ -0,0 +1,60 @@
+#ifndef KHASNULIN_GZIP_STREAM_HPP
+#define KHASNULIN_GZIP_STREAM_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace khasnulin
+{
+
+  std::string deflateGzipMember(const char *data, size_t size);
+
+  // Cuts the stream into independent blocks, compresses them on worker
+  // threads and writes the gzip members to the sink in order.
+  class GzipStreamBuf: public std::streambuf
+  {
+  public:
+    GzipStreamBuf(std::ostream &sink, size_t threads, size_t block_size = 1 << 20);
+    ~GzipStreamBuf() override;
+    GzipStreamBuf(const GzipStreamBuf &) = delete;
+    GzipStreamBuf &operator=(const GzipStreamBuf &) = delete;
+
+    bool finish();
+
+  protected:
+    int_type overflow(int_type ch) override;
+
+  private:
+    struct Job
+    {
+      std::string raw;
+      std::string packed;
+      bool done;
+    };
+
+    std::ostream &sink_;
+    size_t max_jobs_;
+    std::vector< char > buffer_;
+    std::deque< Job > jobs_;
+    std::deque< Job * > todo_;
+    std::vector< std::thread > workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    bool stop_;
+    bool finished_;
+
+    void submit();
+    void writeFront();
+    void work();
+  };
+}
+
+#endif
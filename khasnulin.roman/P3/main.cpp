@@ -1,20 +1,25 @@
 #include <cstddef>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <istream>
 #include <ostream>
 #include <stdexcept>
+#include "gzip_stream.hpp"
+#include "matrix.hpp"
+#include "npy.hpp"
+#include "versioned_matrix.hpp"
 
 namespace khasnulin
 {
 
   size_t getFirstParameter(const char *num);
 
-  std::istream &readMatrix(std::istream &input, int *arr, size_t n, size_t m, size_t &elems_count);
+  size_t getThreadsCount(const char *value);
 
-  void lftBotClk(int *arr, size_t n, size_t m);
+  void runSessionScript(const char *path, int *arr, size_t n, size_t m);
 
-  bool lwrTriMtx(const int *arr, size_t n, size_t m);
+  std::istream &readMatrix(std::istream &input, int *arr, size_t n, size_t m, size_t &elems_count);
 
   std::ostream &printMatrix(std::ostream &output, const int *a, size_t n, size_t m);
 }
@@ -23,6 +28,7 @@ int main(int argc, char **argv)
 {
   size_t mode = 0;
   int *currArr = nullptr;
+  bool owns_arr = false;
   if (argc != 4)
   {
     const char *message = argc > 4 ? "Too many arguments\n" : "Not enough arguments\n";
@@ -33,37 +39,79 @@ int main(int argc, char **argv)
   {
     mode = khasnulin::getFirstParameter(argv[1]);
 
-    std::ifstream input(argv[2]);
     size_t n = 1, m = 1;
 
     int arr[10000] = {};
 
-    input >> n >> m;
-    currArr = mode == 1 ? arr : new int[n * m];
+    khasnulin::NpyMatrix npy;
+    if (khasnulin::isNpyPath(argv[2]))
+    {
+      npy.open(argv[2]);
+      n = npy.rows();
+      m = npy.cols();
+      currArr = npy.data();
+    }
+    else
+    {
+      std::ifstream input(argv[2]);
+      input >> n >> m;
+      currArr = mode == 1 ? arr : new int[n * m];
+      owns_arr = mode == 2;
 
-    size_t elems_count = 0;
-    khasnulin::readMatrix(input, currArr, n, m, elems_count);
+      size_t elems_count = 0;
+      khasnulin::readMatrix(input, currArr, n, m, elems_count);
 
-    if ((!input.eof() && input.fail()) || (elems_count != n * m))
-    {
-      if (mode == 2)
+      if ((!input.eof() && input.fail()) || (elems_count != n * m))
       {
-        delete[] currArr;
+        if (owns_arr)
+        {
+          delete[] currArr;
+        }
+        std::cerr << "Error while reading input file data, can't read as matrix\n";
+        return 2;
       }
-      std::cerr << "Error while reading input file data, can't read as matrix\n";
-      return 2;
     }
-    input.close();
+
+    const char *session = std::getenv("KHASNULIN_SESSION");
+    if (session)
+    {
+      khasnulin::runSessionScript(session, currArr, n, m);
+    }
 
     bool isLWR_TRI_MTX = khasnulin::lwrTriMtx(currArr, n, m);
     khasnulin::lftBotClk(currArr, n, m);
 
-    std::ofstream output(argv[3]);
+    std::ofstream output(argv[3], std::ios::binary);
 
-    khasnulin::printMatrix(output, currArr, n, m);
-    output << std::boolalpha << isLWR_TRI_MTX;
+    const char *gzip = std::getenv("KHASNULIN_GZIP");
+    if (khasnulin::isNpyPath(argv[3]))
+    {
+      khasnulin::writeNpy(output, currArr, n, m);
+      std::cout << std::boolalpha << isLWR_TRI_MTX << "\n";
+    }
+    else if (gzip)
+    {
+      khasnulin::GzipStreamBuf gzip_buf(output, khasnulin::getThreadsCount(gzip));
+      std::ostream gzip_output(&gzip_buf);
+      khasnulin::printMatrix(gzip_output, currArr, n, m);
+      gzip_output << std::boolalpha << isLWR_TRI_MTX;
+      if (!gzip_buf.finish())
+      {
+        if (owns_arr)
+        {
+          delete[] currArr;
+        }
+        std::cerr << "Error while writing compressed output file\n";
+        return 2;
+      }
+    }
+    else
+    {
+      khasnulin::printMatrix(output, currArr, n, m);
+      output << std::boolalpha << isLWR_TRI_MTX;
+    }
 
-    if (mode == 2)
+    if (owns_arr)
     {
       delete[] currArr;
     }
@@ -73,9 +121,18 @@ int main(int argc, char **argv)
     std::cerr << "Error memory allocation\n";
     return 2;
   }
+  catch (const std::overflow_error &e)
+  {
+    if (owns_arr)
+    {
+      delete[] currArr;
+    }
+    std::cerr << e.what() << "\n";
+    return 2;
+  }
   catch (const std::runtime_error &e)
   {
-    if (mode == 2)
+    if (owns_arr)
     {
       delete[] currArr;
     }
@@ -85,7 +142,7 @@ int main(int argc, char **argv)
   catch (...)
   {
     std::cerr << "Error during task execution, something went wrong\n";
-    if (mode == 2)
+    if (owns_arr)
     {
       delete[] currArr;
     }
@@ -116,73 +173,40 @@ size_t khasnulin::getFirstParameter(const char *num)
   throw std::runtime_error("Incorrect first parameter input\n");
 }
 
-void khasnulin::lftBotClk(int *arr, size_t n, size_t m)
+size_t khasnulin::getThreadsCount(const char *value)
 {
-  if (n > 0 && m > 0)
+  char *end = nullptr;
+  unsigned long threads = std::strtoul(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || threads == 0)
   {
-    size_t currI = (n - 1) * m;
-
-    int directionI = -1;
-    int directionJ = 0;
-    int factor = 1;
-    size_t spiral_circle = 0;
-    size_t elem_counter = 0;
-    for (size_t i = 0; i < n * m; i++)
-    {
-      arr[currI] -= factor;
-      factor++;
-      elem_counter++;
-      if (directionI && elem_counter == (n - spiral_circle))
-      {
-        if (directionI == -1)
-        {
-          directionJ = 1;
-        }
-        else
-        {
-          directionJ = -1;
-        }
-        spiral_circle++;
-        elem_counter = 0;
-        directionI = 0;
-      }
-      else if (directionJ && elem_counter == (m - spiral_circle))
-      {
-        if (directionJ == -1)
-        {
-          directionI = -1;
-        }
-        else
-        {
-          directionI = 1;
-        }
-        elem_counter = 0;
-        directionJ = 0;
-      }
-      currI += directionI * m + directionJ;
-    }
+    threads = std::thread::hardware_concurrency();
   }
+  return threads > 0 ? threads : 1;
 }
 
-bool khasnulin::lwrTriMtx(const int *arr, size_t n, size_t m)
+void khasnulin::runSessionScript(const char *path, int *arr, size_t n, size_t m)
 {
-  size_t minSide = std::min(n, m);
-  if (minSide == 0)
+  std::ifstream script(path);
+  if (!script.is_open())
   {
-    return false;
+    throw std::runtime_error("Can't open session script");
   }
-  for (size_t i = 0; i < minSide; i++)
+  const char *block_rows = std::getenv("KHASNULIN_BLOCK_ROWS");
+  size_t rows_per_block = block_rows ? std::strtoul(block_rows, nullptr, 10) : 0;
+  khasnulin::VersionedMatrix mtx(arr, n, m, rows_per_block ? rows_per_block : 64);
+  const char *readers = std::getenv("KHASNULIN_SESSION_READERS");
+  size_t threads = getThreadsCount(readers ? readers : "");
+  const char *out = std::getenv("KHASNULIN_SESSION_OUT");
+  if (out)
   {
-    for (size_t j = i + 1; j < m; j++)
-    {
-      if (arr[i * m + j] != 0)
-      {
-        return false;
-      }
-    }
+    std::ofstream output(out);
+    khasnulin::runSession(script, output, mtx, threads);
   }
-
-  return true;
+  else
+  {
+    khasnulin::runSession(script, std::cout, mtx, threads);
+  }
+  mtx.copyTo(arr);
 }
 
 using is_t = std::istream;
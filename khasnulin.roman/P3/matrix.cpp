@@ -0,0 +1,97 @@
+#include "matrix.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+void khasnulin::checkSegmentOverflow(bool overflow, size_t cell, size_t m)
+{
+  if (overflow)
+  {
+    throw std::overflow_error("Spiral subtraction overflow at " + std::to_string(cell / m) + " " + std::to_string(cell % m));
+  }
+}
+
+void khasnulin::lftBotClk(int *arr, size_t n, size_t m)
+{
+  if (n > 0 && m > 0)
+  {
+    const long long int_min = std::numeric_limits< int >::min();
+    size_t currI = (n - 1) * m;
+
+    int directionI = -1;
+    int directionJ = 0;
+    int factor = 1;
+    size_t spiral_circle = 0;
+    size_t elem_counter = 0;
+    bool segment_overflow = false;
+    size_t first_bad = 0;
+    for (size_t i = 0; i < n * m; i++)
+    {
+      long long value = static_cast< long long >(arr[currI]) - factor;
+      bool overflow = value < int_min;
+      arr[currI] = static_cast< int >(value);
+      first_bad = overflow && !segment_overflow ? currI : first_bad;
+      segment_overflow = segment_overflow || overflow;
+      factor++;
+      elem_counter++;
+      if (directionI && elem_counter == (n - spiral_circle))
+      {
+        if (directionI == -1)
+        {
+          directionJ = 1;
+        }
+        else
+        {
+          directionJ = -1;
+        }
+        checkSegmentOverflow(segment_overflow, first_bad, m);
+        spiral_circle++;
+        elem_counter = 0;
+        directionI = 0;
+      }
+      else if (directionJ && elem_counter == (m - spiral_circle))
+      {
+        if (directionJ == -1)
+        {
+          directionI = -1;
+        }
+        else
+        {
+          directionI = 1;
+        }
+        checkSegmentOverflow(segment_overflow, first_bad, m);
+        elem_counter = 0;
+        directionJ = 0;
+      }
+      currI += directionI * m + directionJ;
+    }
+    checkSegmentOverflow(segment_overflow, first_bad, m);
+  }
+}
+
+bool khasnulin::lwrTriMtx(const int *arr, size_t n, size_t m)
+{
+  size_t minSide = std::min(n, m);
+  if (minSide == 0)
+  {
+    return false;
+  }
+  return lwrTriRows(arr, 0, minSide, m);
+}
+
+bool khasnulin::lwrTriRows(const int *rows, size_t first, size_t count, size_t m)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    for (size_t j = first + i + 1; j < m; j++)
+    {
+      if (rows[i * m + j] != 0)
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,18 @@
+#ifndef KHASNULIN_MATRIX_HPP
+#define KHASNULIN_MATRIX_HPP
+
+#include <cstddef>
+
+namespace khasnulin
+{
+
+  void checkSegmentOverflow(bool overflow, size_t cell, size_t m);
+
+  void lftBotClk(int *arr, size_t n, size_t m);
+
+  bool lwrTriMtx(const int *arr, size_t n, size_t m);
+
+  bool lwrTriRows(const int *rows, size_t first, size_t count, size_t m);
+}
+
+#endif
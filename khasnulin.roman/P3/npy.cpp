@@ -0,0 +1,323 @@
+#include "npy.hpp"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace khasnulin
+{
+  namespace
+  {
+    const char NPY_MAGIC[] = "\x93NUMPY";
+    const size_t NPY_MAGIC_SIZE = 6;
+    const size_t NPY_ALIGN = 64;
+
+    struct NpyHeader
+    {
+      char kind;
+      size_t item_size;
+      bool big_endian;
+      bool fortran_order;
+      size_t rows;
+      size_t cols;
+      size_t data_offset;
+    };
+
+    bool isLittleEndian()
+    {
+      const uint16_t probe = 1;
+      return *reinterpret_cast< const unsigned char * >(&probe) == 1;
+    }
+
+    void badHeader(const std::string &what)
+    {
+      throw std::runtime_error("Unsupported .npy header: " + what);
+    }
+
+    size_t findValue(const std::string &dict, const char *key)
+    {
+      for (char quote: {'\'', '"'})
+      {
+        std::string quoted = quote + std::string(key) + quote;
+        size_t pos = dict.find(quoted);
+        if (pos != std::string::npos)
+        {
+          pos = dict.find(':', pos + quoted.size());
+          pos = pos == std::string::npos ? pos : dict.find_first_not_of(' ', pos + 1);
+          if (pos != std::string::npos)
+          {
+            return pos;
+          }
+        }
+      }
+      badHeader(std::string("no ") + key);
+      return 0;
+    }
+
+    size_t readSize(const std::string &dict, size_t &pos)
+    {
+      size_t first = pos;
+      size_t value = 0;
+      while (pos < dict.size() && dict[pos] >= '0' && dict[pos] <= '9')
+      {
+        if (value > (std::numeric_limits< size_t >::max() - 9) / 10)
+        {
+          badHeader("shape is too large");
+        }
+        value = value * 10 + static_cast< size_t >(dict[pos] - '0');
+        pos++;
+      }
+      if (pos == first)
+      {
+        badHeader("bad shape");
+      }
+      pos += pos < dict.size() && dict[pos] == 'L';
+      return value;
+    }
+
+    void parseDict(const std::string &dict, NpyHeader &header)
+    {
+      size_t pos = findValue(dict, "descr");
+      if (dict[pos] != '\'' && dict[pos] != '"')
+      {
+        badHeader("descr is not a simple type");
+      }
+      size_t end = dict.find(dict[pos], pos + 1);
+      std::string descr = dict.substr(pos + 1, end == std::string::npos ? 0 : end - pos - 1);
+      if (descr.size() < 3 || (descr[1] != 'i' && descr[1] != 'u'))
+      {
+        badHeader("descr '" + descr + "'");
+      }
+      char order = descr[0];
+      header.kind = descr[1];
+      header.item_size = descr.substr(2) == "1" ? 1 : descr.substr(2) == "2" ? 2 : 0;
+      header.item_size = descr.substr(2) == "4" ? 4 : descr.substr(2) == "8" ? 8 : header.item_size;
+      if (header.item_size == 0 || (order != '<' && order != '>' && order != '|' && order != '='))
+      {
+        badHeader("descr '" + descr + "'");
+      }
+      header.big_endian = order == '>' || (order == '=' && !isLittleEndian());
+
+      pos = findValue(dict, "fortran_order");
+      header.fortran_order = dict.compare(pos, 4, "True") == 0;
+      if (!header.fortran_order && dict.compare(pos, 5, "False") != 0)
+      {
+        badHeader("bad fortran_order");
+      }
+
+      pos = findValue(dict, "shape");
+      if (dict[pos] != '(')
+      {
+        badHeader("bad shape");
+      }
+      pos = dict.find_first_not_of(' ', pos + 1);
+      header.rows = readSize(dict, pos);
+      pos = dict.find_first_not_of(' ', pos);
+      if (pos == std::string::npos || dict[pos] != ',')
+      {
+        badHeader("matrix must be two-dimensional");
+      }
+      pos = dict.find_first_not_of(' ', pos + 1);
+      header.cols = readSize(dict, pos);
+      pos = dict.find_first_not_of(' ', pos);
+      pos += pos != std::string::npos && dict[pos] == ',';
+      pos = dict.find_first_not_of(' ', pos);
+      if (pos == std::string::npos || dict[pos] != ')')
+      {
+        badHeader("matrix must be two-dimensional");
+      }
+    }
+
+    NpyHeader parseHeader(const unsigned char *file, size_t size)
+    {
+      if (size < NPY_MAGIC_SIZE + 4 || std::memcmp(file, NPY_MAGIC, NPY_MAGIC_SIZE) != 0)
+      {
+        throw std::runtime_error("Input file is not a .npy file");
+      }
+      unsigned major = file[NPY_MAGIC_SIZE];
+      size_t len_size = major == 1 ? 2 : 4;
+      if (major < 1 || major > 3 || size < NPY_MAGIC_SIZE + 2 + len_size)
+      {
+        badHeader("version " + std::to_string(major));
+      }
+      size_t dict_size = 0;
+      for (size_t b = 0; b < len_size; b++)
+      {
+        dict_size |= static_cast< size_t >(file[NPY_MAGIC_SIZE + 2 + b]) << (8 * b);
+      }
+      size_t dict_start = NPY_MAGIC_SIZE + 2 + len_size;
+      if (dict_size > size - dict_start)
+      {
+        badHeader("truncated");
+      }
+      NpyHeader header{0, 0, false, false, 0, 0, dict_start + dict_size};
+      parseDict(std::string(reinterpret_cast< const char * >(file) + dict_start, dict_size), header);
+      size_t count = header.rows * header.cols;
+      if (header.rows && count / header.rows != header.cols)
+      {
+        badHeader("shape is too large");
+      }
+      if (count > (size - header.data_offset) / header.item_size)
+      {
+        throw std::runtime_error("Input .npy payload is shorter than its shape");
+      }
+      return header;
+    }
+
+    int readItem(const unsigned char *p, const NpyHeader &header, size_t index)
+    {
+      size_t size = header.item_size;
+      unsigned long long bits = 0;
+      for (size_t b = 0; b < size; b++)
+      {
+        size_t shift = header.big_endian ? size - 1 - b : b;
+        bits |= static_cast< unsigned long long >(p[b]) << (8 * shift);
+      }
+      bool negative = header.kind == 'i' && ((bits >> (8 * size - 1)) & 1);
+      if (negative && size < 8)
+      {
+        bits |= ~0ULL << (8 * size);
+      }
+      const unsigned long long int_max = std::numeric_limits< int >::max();
+      bool fits = negative ? ~bits <= int_max : bits <= int_max;
+      if (!fits)
+      {
+        throw std::overflow_error("Value out of int range in .npy input at element " + std::to_string(index));
+      }
+      return negative ? -static_cast< int >(~bits) - 1 : static_cast< int >(bits);
+    }
+  }
+}
+
+bool khasnulin::isNpyPath(const char *path)
+{
+  size_t len = std::strlen(path);
+  return len >= 4 && std::strcmp(path + len - 4, ".npy") == 0;
+}
+
+khasnulin::NpyMatrix::NpyMatrix():
+  map_(nullptr),
+  map_size_(0),
+  data_(nullptr),
+  rows_(0),
+  cols_(0)
+{}
+
+khasnulin::NpyMatrix::~NpyMatrix()
+{
+  close();
+}
+
+void khasnulin::NpyMatrix::close()
+{
+  if (map_)
+  {
+    ::munmap(map_, map_size_);
+  }
+  map_ = nullptr;
+  map_size_ = 0;
+  data_ = nullptr;
+  converted_.clear();
+}
+
+void khasnulin::NpyMatrix::open(const char *path)
+{
+  close();
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || ::fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+    throw std::runtime_error("Can't open .npy input file");
+  }
+  map_size_ = static_cast< size_t >(st.st_size);
+  // a private writable mapping lets lftBotClk work on the payload directly;
+  // touched pages are copied and the file itself is never changed
+  void *map = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+  {
+    map_size_ = 0;
+    throw std::runtime_error("Can't map .npy input file");
+  }
+  map_ = map;
+
+  unsigned char *file = static_cast< unsigned char * >(map_);
+  NpyHeader header = parseHeader(file, map_size_);
+  rows_ = header.rows;
+  cols_ = header.cols;
+  unsigned char *payload = file + header.data_offset;
+  bool native = header.big_endian != isLittleEndian() || header.item_size == 1;
+  bool direct = header.kind == 'i' && header.item_size == sizeof(int) && native && !header.fortran_order;
+  if (direct && header.data_offset % alignof(int) == 0)
+  {
+    data_ = reinterpret_cast< int * >(payload);
+    return;
+  }
+
+  converted_.resize(rows_ * cols_);
+  for (size_t i = 0; i < rows_; i++)
+  {
+    for (size_t j = 0; j < cols_; j++)
+    {
+      size_t index = header.fortran_order ? j * rows_ + i : i * cols_ + j;
+      converted_[i * cols_ + j] = readItem(payload + index * header.item_size, header, index);
+    }
+  }
+  data_ = converted_.data();
+  ::munmap(map_, map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+}
+
+size_t khasnulin::NpyMatrix::rows() const
+{
+  return rows_;
+}
+
+size_t khasnulin::NpyMatrix::cols() const
+{
+  return cols_;
+}
+
+int *khasnulin::NpyMatrix::data()
+{
+  return data_;
+}
+
+bool khasnulin::NpyMatrix::isMapped() const
+{
+  return map_ != nullptr;
+}
+
+std::ostream &khasnulin::writeNpy(std::ostream &output, const int *a, size_t n, size_t m)
+{
+  std::string dict = "{'descr': '";
+  dict += isLittleEndian() ? '<' : '>';
+  dict += "i" + std::to_string(sizeof(int)) + "', 'fortran_order': False, 'shape': (";
+  dict += std::to_string(n) + ", " + std::to_string(m) + "), }";
+  size_t prefix = NPY_MAGIC_SIZE + 4;
+  dict.append(NPY_ALIGN - 1 - (prefix + dict.size()) % NPY_ALIGN, ' ');
+  dict += '\n';
+
+  output.write(NPY_MAGIC, NPY_MAGIC_SIZE);
+  output.put(1);
+  output.put(0);
+  output.put(static_cast< char >(dict.size() & 0xFF));
+  output.put(static_cast< char >(dict.size() >> 8));
+  output << dict;
+  if (n > 0 && m > 0)
+  {
+    output.write(reinterpret_cast< const char * >(a), static_cast< std::streamsize >(n * m * sizeof(int)));
+  }
+  return output;
+}
@@ -0,0 +1,44 @@
+#ifndef KHASNULIN_NPY_HPP
+#define KHASNULIN_NPY_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace khasnulin
+{
+
+  bool isNpyPath(const char *path);
+
+  // Two-dimensional integer .npy file (int8-int64 or uint8-uint64, any byte
+  // order, C or Fortran order). The file is mapped privately; a native int32
+  // C-order payload is used in place, anything else is converted once.
+  class NpyMatrix
+  {
+  public:
+    NpyMatrix();
+    ~NpyMatrix();
+    NpyMatrix(const NpyMatrix &) = delete;
+    NpyMatrix &operator=(const NpyMatrix &) = delete;
+
+    void open(const char *path);
+    size_t rows() const;
+    size_t cols() const;
+    int *data();
+    bool isMapped() const;
+
+  private:
+    void *map_;
+    size_t map_size_;
+    int *data_;
+    std::vector< int > converted_;
+    size_t rows_;
+    size_t cols_;
+
+    void close();
+  };
+
+  std::ostream &writeNpy(std::ostream &output, const int *a, size_t n, size_t m);
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include "versioned_matrix.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include "matrix.hpp"
+
+const size_t khasnulin::VersionedMatrix::reader_slots;
+
+khasnulin::VersionedMatrix::Snapshot::Snapshot(const VersionedMatrix *owner, size_t slot, const Table *table):
+  owner_(owner),
+  slot_(slot),
+  table_(table)
+{}
+
+khasnulin::VersionedMatrix::Snapshot::Snapshot(Snapshot &&other) noexcept:
+  owner_(other.owner_),
+  slot_(other.slot_),
+  table_(other.table_)
+{
+  other.owner_ = nullptr;
+}
+
+khasnulin::VersionedMatrix::Snapshot::~Snapshot()
+{
+  if (owner_)
+  {
+    owner_->release(slot_);
+  }
+}
+
+size_t khasnulin::VersionedMatrix::Snapshot::rows() const
+{
+  return owner_->n_;
+}
+
+size_t khasnulin::VersionedMatrix::Snapshot::cols() const
+{
+  return owner_->m_;
+}
+
+uint64_t khasnulin::VersionedMatrix::Snapshot::version() const
+{
+  return table_->version;
+}
+
+const int *khasnulin::VersionedMatrix::Snapshot::row(size_t i) const
+{
+  size_t block_rows = owner_->block_rows_;
+  return table_->blocks[i / block_rows] + (i % block_rows) * owner_->m_;
+}
+
+khasnulin::VersionedMatrix::VersionedMatrix(const int *arr, size_t n, size_t m, size_t block_rows):
+  n_(n),
+  m_(m),
+  block_rows_(std::max< size_t >(block_rows, 1)),
+  current_(nullptr),
+  epoch_(1)
+{
+  for (std::atomic< uint64_t > &slot: slots_)
+  {
+    slot.store(0);
+  }
+  Table *table = new Table{{}, 0};
+  for (size_t first = 0; first < n_; first += block_rows_)
+  {
+    size_t size = std::min(block_rows_, n_ - first) * m_;
+    table->blocks.push_back(new int[size]);
+    std::copy(arr + first * m_, arr + first * m_ + size, table->blocks.back());
+  }
+  current_.store(table);
+}
+
+khasnulin::VersionedMatrix::~VersionedMatrix()
+{
+  for (const std::pair< uint64_t, int * > &block: retired_blocks_)
+  {
+    delete[] block.second;
+  }
+  for (const std::pair< uint64_t, const Table * > &table: retired_tables_)
+  {
+    delete table.second;
+  }
+  const Table *table = current_.load();
+  for (int *block: table->blocks)
+  {
+    delete[] block;
+  }
+  delete table;
+}
+
+khasnulin::VersionedMatrix::Snapshot khasnulin::VersionedMatrix::snapshot() const
+{
+  size_t slot = std::hash< std::thread::id >()(std::this_thread::get_id()) % reader_slots;
+  while (true)
+  {
+    uint64_t expected = 0;
+    if (slots_[slot].compare_exchange_strong(expected, epoch_.load()))
+    {
+      break;
+    }
+    slot = (slot + 1) % reader_slots;
+  }
+  return Snapshot(this, slot, current_.load());
+}
+
+void khasnulin::VersionedMatrix::apply(const std::vector< Update > &updates)
+{
+  if (updates.empty())
+  {
+    return;
+  }
+  std::lock_guard< std::mutex > lock(writer_);
+  const Table *old_table = current_.load();
+  Table *table = new Table{old_table->blocks, old_table->version + 1};
+  std::vector< int * > replaced;
+  for (const Update &u: updates)
+  {
+    if (u.i >= n_ || u.j >= m_)
+    {
+      for (size_t b = 0; b < table->blocks.size(); b++)
+      {
+        if (table->blocks[b] != old_table->blocks[b])
+        {
+          delete[] table->blocks[b];
+        }
+      }
+      delete table;
+      throw std::out_of_range("Matrix update out of range");
+    }
+    size_t b = u.i / block_rows_;
+    if (table->blocks[b] == old_table->blocks[b])
+    {
+      size_t size = std::min(block_rows_, n_ - b * block_rows_) * m_;
+      table->blocks[b] = new int[size];
+      std::copy(old_table->blocks[b], old_table->blocks[b] + size, table->blocks[b]);
+      replaced.push_back(old_table->blocks[b]);
+    }
+    table->blocks[b][(u.i % block_rows_) * m_ + u.j] = u.value;
+  }
+  current_.store(table);
+  uint64_t retired_at = epoch_.fetch_add(1);
+  retired_tables_.emplace_back(retired_at, old_table);
+  for (int *block: replaced)
+  {
+    retired_blocks_.emplace_back(retired_at, block);
+  }
+  reclaim();
+}
+
+size_t khasnulin::VersionedMatrix::rows() const
+{
+  return n_;
+}
+
+size_t khasnulin::VersionedMatrix::cols() const
+{
+  return m_;
+}
+
+void khasnulin::VersionedMatrix::copyTo(int *arr) const
+{
+  Snapshot snap = snapshot();
+  for (size_t i = 0; i < n_; i++)
+  {
+    std::copy(snap.row(i), snap.row(i) + m_, arr + i * m_);
+  }
+}
+
+void khasnulin::VersionedMatrix::release(size_t slot) const
+{
+  slots_[slot].store(0);
+}
+
+void khasnulin::VersionedMatrix::reclaim()
+{
+  uint64_t oldest = std::numeric_limits< uint64_t >::max();
+  for (const std::atomic< uint64_t > &slot: slots_)
+  {
+    uint64_t pinned = slot.load();
+    oldest = pinned ? std::min(oldest, pinned) : oldest;
+  }
+  auto block_freed = [oldest](const std::pair< uint64_t, int * > &block) {
+    if (block.first < oldest)
+    {
+      delete[] block.second;
+      return true;
+    }
+    return false;
+  };
+  auto table_freed = [oldest](const std::pair< uint64_t, const Table * > &table) {
+    if (table.first < oldest)
+    {
+      delete table.second;
+      return true;
+    }
+    return false;
+  };
+  retired_blocks_.erase(std::remove_if(retired_blocks_.begin(), retired_blocks_.end(), block_freed),
+      retired_blocks_.end());
+  retired_tables_.erase(std::remove_if(retired_tables_.begin(), retired_tables_.end(), table_freed),
+      retired_tables_.end());
+}
+
+namespace khasnulin
+{
+  namespace
+  {
+    bool lwrTriSnapshot(const VersionedMatrix::Snapshot &snap)
+    {
+      size_t minSide = std::min(snap.rows(), snap.cols());
+      if (minSide == 0)
+      {
+        return false;
+      }
+      for (size_t i = 0; i < minSide; i++)
+      {
+        if (!lwrTriRows(snap.row(i), i, 1, snap.cols()))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+}
+
+std::ostream &khasnulin::runSession(std::istream &script, std::ostream &output, VersionedMatrix &mtx, size_t readers)
+{
+  using Job = std::pair< size_t, VersionedMatrix::Snapshot >;
+  std::deque< Job > jobs;
+  std::vector< std::pair< uint64_t, bool > > results;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::condition_variable space;
+  const size_t max_pinned = VersionedMatrix::reader_slots / 2;
+  size_t pinned = 0;
+  bool done = false;
+
+  auto work = [&]() {
+    std::unique_lock< std::mutex > lock(mutex);
+    while (true)
+    {
+      cv.wait(lock, [&]() {
+        return done || !jobs.empty();
+      });
+      if (jobs.empty())
+      {
+        return;
+      }
+      size_t index = 0;
+      std::pair< uint64_t, bool > res(0, false);
+      {
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        index = job.first;
+        res = std::make_pair(job.second.version(), lwrTriSnapshot(job.second));
+      }
+      lock.lock();
+      results[index] = res;
+      pinned--;
+      space.notify_one();
+    }
+  };
+  std::vector< std::thread > workers;
+  auto stop = [&]() {
+    {
+      std::lock_guard< std::mutex > lock(mutex);
+      done = true;
+    }
+    cv.notify_all();
+    for (std::thread &w: workers)
+    {
+      w.join();
+    }
+  };
+  try
+  {
+    for (size_t r = 0; r < std::max< size_t >(readers, 1); r++)
+    {
+      workers.emplace_back(work);
+    }
+  }
+  catch (const std::system_error &)
+  {
+    if (workers.empty())
+    {
+      throw;
+    }
+  }
+
+  std::vector< VersionedMatrix::Update > pending;
+  std::string line;
+  size_t line_no = 0;
+  try
+  {
+    while (std::getline(script, line))
+    {
+      line_no++;
+      std::istringstream fields(line);
+      std::string command;
+      if (!(fields >> command))
+      {
+        continue;
+      }
+      if (command == "set")
+      {
+        VersionedMatrix::Update u{0, 0, 0};
+        if (!(fields >> u.i >> u.j >> u.value) || u.i >= mtx.rows() || u.j >= mtx.cols())
+        {
+          throw std::runtime_error("Bad session command at line " + std::to_string(line_no));
+        }
+        pending.push_back(u);
+      }
+      else if (command == "query")
+      {
+        mtx.apply(pending);
+        pending.clear();
+        {
+          std::unique_lock< std::mutex > lock(mutex);
+          space.wait(lock, [&]() {
+            return pinned < max_pinned;
+          });
+          pinned++;
+          results.emplace_back(0, false);
+        }
+        VersionedMatrix::Snapshot snap = mtx.snapshot();
+        {
+          std::lock_guard< std::mutex > lock(mutex);
+          jobs.emplace_back(results.size() - 1, std::move(snap));
+        }
+        cv.notify_one();
+      }
+      else
+      {
+        throw std::runtime_error("Bad session command at line " + std::to_string(line_no));
+      }
+    }
+    mtx.apply(pending);
+  }
+  catch (...)
+  {
+    stop();
+    throw;
+  }
+  stop();
+
+  for (const std::pair< uint64_t, bool > &res: results)
+  {
+    output << res.first << " " << std::boolalpha << res.second << "\n";
+  }
+  return output;
+}
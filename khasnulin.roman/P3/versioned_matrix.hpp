@@ -0,0 +1,95 @@
+#ifndef KHASNULIN_VERSIONED_MATRIX_HPP
+#define KHASNULIN_VERSIONED_MATRIX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace khasnulin
+{
+
+  // Matrix split into row blocks that are never modified in place. A write
+  // copies the touched blocks and publishes a new block table; readers pin
+  // the current table through an epoch slot and never take a lock. Old
+  // tables and blocks are freed once no pinned epoch can still see them.
+  class VersionedMatrix
+  {
+    struct Table
+    {
+      std::vector< int * > blocks;
+      uint64_t version;
+    };
+
+  public:
+    static const size_t reader_slots = 256;
+
+    class Snapshot
+    {
+    public:
+      Snapshot(Snapshot &&other) noexcept;
+      ~Snapshot();
+      Snapshot(const Snapshot &) = delete;
+      Snapshot &operator=(const Snapshot &) = delete;
+      Snapshot &operator=(Snapshot &&) = delete;
+
+      size_t rows() const;
+      size_t cols() const;
+      uint64_t version() const;
+      const int *row(size_t i) const;
+
+    private:
+      friend class VersionedMatrix;
+      Snapshot(const VersionedMatrix *owner, size_t slot, const Table *table);
+
+      const VersionedMatrix *owner_;
+      size_t slot_;
+      const Table *table_;
+    };
+
+    struct Update
+    {
+      size_t i;
+      size_t j;
+      int value;
+    };
+
+    VersionedMatrix(const int *arr, size_t n, size_t m, size_t block_rows);
+    ~VersionedMatrix();
+    VersionedMatrix(const VersionedMatrix &) = delete;
+    VersionedMatrix &operator=(const VersionedMatrix &) = delete;
+
+    size_t rows() const;
+    size_t cols() const;
+    Snapshot snapshot() const;
+    void apply(const std::vector< Update > &updates);
+    void copyTo(int *arr) const;
+
+  private:
+    size_t n_;
+    size_t m_;
+    size_t block_rows_;
+    std::atomic< const Table * > current_;
+    std::atomic< uint64_t > epoch_;
+    mutable std::atomic< uint64_t > slots_[reader_slots];
+    std::mutex writer_;
+    std::vector< std::pair< uint64_t, const Table * > > retired_tables_;
+    std::vector< std::pair< uint64_t, int * > > retired_blocks_;
+
+    void release(size_t slot) const;
+    void reclaim();
+  };
+
+  // Runs "set i j value" and "query" commands; queries are answered on a
+  // snapshot taken at their position in the script, by reader threads that
+  // run concurrently with the following writes. At most half of the epoch
+  // slots are held by queued or running queries; the script waits for a
+  // reader to finish before pinning more.
+  std::ostream &runSession(std::istream &script, std::ostream &output, VersionedMatrix &mtx, size_t readers);
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "matrix.hpp"
+#include "packed.hpp"
+#include "parallel.hpp"
+
+namespace kuznetsov {
+  namespace {
+    const double MIN_SAMPLE_TIME = 1e-3;
+    const double ALPHA = 0.01;
+
+    double median(std::vector< double > v)
+    {
+      if (v.empty()) {
+        return 0.0;
+      }
+      std::sort(v.begin(), v.end());
+      size_t n = v.size();
+      return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    }
+
+    template< class F >
+    double timeCalls(F f, size_t reps)
+    {
+      volatile int sink = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t r = 0; r < reps; ++r) {
+        sink = sink + f();
+      }
+      std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count() / reps;
+    }
+
+    template< class F >
+    BenchSeries sample(const char* kernel, size_t size, size_t samples, F f)
+    {
+      size_t reps = 1;
+      while (timeCalls(f, reps) * reps < MIN_SAMPLE_TIME && reps < (1u << 20)) {
+        reps *= 2;
+      }
+      BenchSeries res{kernel, size, {}};
+      for (size_t s = 0; s < samples; ++s) {
+        res.samples.push_back(timeCalls(f, reps));
+      }
+      return res;
+    }
+  }
+}
+
+std::vector< kuznetsov::BenchSeries > kuznetsov::runBench(size_t samples)
+{
+  const size_t sizes[] = {64, 256, 1024};
+  std::vector< BenchSeries > res;
+  for (size_t n: sizes) {
+    std::vector< int > mtx(n * n);
+    std::minstd_rand gen(n);
+    std::uniform_int_distribution< int > dist(0, 1023);
+    for (int& v: mtx) {
+      v = dist(gen);
+    }
+    PackedMatrix packed{0, 0, 0, {}, {}, {}, {}};
+    initPacked(packed, n, n);
+    for (size_t i = 0; i < n; ++i) {
+      packRow(packed, mtx.data() + i * n);
+    }
+    const int* m = mtx.data();
+    BandConfig bands{std::max(1u, std::thread::hardware_concurrency()), 0};
+    bands.bandRows = std::max< size_t >(1, n / (bands.threads * 4));
+    res.push_back(sample("getCntColNsm", n, samples, [&]() {
+      return getCntColNsm(m, n, n);
+    }));
+    res.push_back(sample("getCntColNsmTiled", n, samples, [&]() {
+      return getCntColNsmTiled(m, n, n, 64);
+    }));
+    res.push_back(sample("getCntColNsmPacked", n, samples, [&]() {
+      return getCntColNsmPacked(packed);
+    }));
+    res.push_back(sample("getCntLocMax", n, samples, [&]() {
+      return getCntLocMax(m, n, n);
+    }));
+    res.push_back(sample("getCntLocMaxBands", n, samples, [&]() {
+      return getCntLocMaxBands(m, n, n, bands);
+    }));
+    res.push_back(sample("getCntLocMaxPacked", n, samples, [&]() {
+      return getCntLocMaxPacked(packed);
+    }));
+  }
+  return res;
+}
+
+std::ostream& kuznetsov::writeBench(std::ostream& output, const std::vector< BenchSeries >& series)
+{
+  output.precision(9);
+  for (const BenchSeries& s: series) {
+    output << s.kernel << ' ' << s.size;
+    for (double t: s.samples) {
+      output << ' ' << t;
+    }
+    output << '\n';
+  }
+  return output;
+}
+
+std::istream& kuznetsov::readBench(std::istream& input, std::vector< BenchSeries >& series)
+{
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream fields(line);
+    BenchSeries s{"", 0, {}};
+    if (!(fields >> s.kernel >> s.size)) {
+      continue;
+    }
+    double t = 0.0;
+    while (fields >> t) {
+      s.samples.push_back(t);
+    }
+    series.push_back(s);
+  }
+  return input;
+}
+
+double kuznetsov::mannWhitneyP(const std::vector< double >& a, const std::vector< double >& b)
+{
+  size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+  if (n1 == 0 || n2 == 0) {
+    return 1.0;
+  }
+  std::vector< std::pair< double, bool > > all;
+  for (double v: a) {
+    all.emplace_back(v, true);
+  }
+  for (double v: b) {
+    all.emplace_back(v, false);
+  }
+  std::sort(all.begin(), all.end());
+  double rankA = 0.0, ties = 0.0;
+  for (size_t i = 0; i < n;) {
+    size_t j = i;
+    while (j < n && all[j].first == all[i].first) {
+      ++j;
+    }
+    double rank = (i + j + 1) / 2.0;
+    for (size_t k = i; k < j; ++k) {
+      rankA += all[k].second ? rank : 0.0;
+    }
+    double t = j - i;
+    ties += t * t * t - t;
+    i = j;
+  }
+  double u = rankA - n1 * (n1 + 1) / 2.0;
+  double mean = n1 * n2 / 2.0;
+  double var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1.0)));
+  if (var <= 0.0) {
+    return 1.0;
+  }
+  double z = (std::fabs(u - mean) - 0.5) / std::sqrt(var);
+  return std::min(1.0, std::erfc(std::max(z, 0.0) / std::sqrt(2.0)));
+}
+
+kuznetsov::BenchVerdict kuznetsov::compareSeries(const BenchSeries& before, const BenchSeries& after, double minEffect, double alpha)
+{
+  BenchVerdict res{median(before.samples), median(after.samples), 0.0, mannWhitneyP(before.samples, after.samples), 0};
+  res.change = res.oldMedian > 0.0 ? res.newMedian / res.oldMedian - 1.0 : 0.0;
+  if (res.pValue < alpha && res.change > minEffect) {
+    res.direction = 1;
+  } else if (res.pValue < alpha && res.change < -minEffect) {
+    res.direction = -1;
+  }
+  return res;
+}
+
+int kuznetsov::compareBench(std::istream& before, std::istream& after, std::ostream& output, double minEffect)
+{
+  std::vector< BenchSeries > oldSeries, newSeries;
+  readBench(before, oldSeries);
+  readBench(after, newSeries);
+  if (oldSeries.empty() || newSeries.empty()) {
+    return 2;
+  }
+  int status = 0;
+  output << "kernel size old_median new_median change p verdict\n";
+  for (const BenchSeries& s: newSeries) {
+    auto old = std::find_if(oldSeries.begin(), oldSeries.end(), [&s](const BenchSeries& o) {
+      return o.kernel == s.kernel && o.size == s.size;
+    });
+    if (old == oldSeries.end()) {
+      output << s.kernel << ' ' << s.size << " - - - - new\n";
+      continue;
+    }
+    BenchVerdict v = compareSeries(*old, s, minEffect, ALPHA);
+    const char* verdict = v.direction > 0 ? "slower" : v.direction < 0 ? "faster" : "same";
+    output << s.kernel << ' ' << s.size << ' ' << v.oldMedian << ' ' << v.newMedian << ' ';
+    output << v.change * 100 << "% " << v.pValue << ' ' << verdict << '\n';
+    status = v.direction > 0 ? 1 : status;
+  }
+  return status;
+}
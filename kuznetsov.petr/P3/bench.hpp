@@ -0,0 +1,33 @@
+#ifndef KUZNETSOV_BENCH_HPP
+#define KUZNETSOV_BENCH_HPP
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace kuznetsov {
+  struct BenchSeries {
+    std::string kernel;
+    size_t size;
+    std::vector< double > samples;
+  };
+
+  struct BenchVerdict {
+    double oldMedian;
+    double newMedian;
+    double change;
+    double pValue;
+    int direction;
+  };
+
+  std::vector< BenchSeries > runBench(size_t samples);
+  std::ostream& writeBench(std::ostream& output, const std::vector< BenchSeries >& series);
+  std::istream& readBench(std::istream& input, std::vector< BenchSeries >& series);
+
+  double mannWhitneyP(const std::vector< double >& a, const std::vector< double >& b);
+  BenchVerdict compareSeries(const BenchSeries& before, const BenchSeries& after, double minEffect, double alpha);
+  int compareBench(std::istream& before, std::istream& after, std::ostream& output, double minEffect);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+#include "matrix.hpp"
+
+namespace kuznetsov {
+  namespace {
+    using Kernel = int (*)(const int*, size_t, size_t);
+
+    int callDense(Kernel kernel, const int* mtx, size_t stride, size_t rows, size_t cols, int* result)
+    {
+      if ((rows && cols && (!mtx || stride < cols)) || !result) {
+        return KUZNETSOV_EINVAL;
+      }
+      if (stride == cols || rows == 0 || cols == 0) {
+        *result = kernel(mtx, rows, cols);
+        return KUZNETSOV_OK;
+      }
+      try {
+        std::vector< int > dense(rows * cols);
+        for (size_t i = 0; i < rows; ++i) {
+          std::copy(mtx + i * stride, mtx + i * stride + cols, dense.data() + i * cols);
+        }
+        *result = kernel(dense.data(), rows, cols);
+      } catch (const std::bad_alloc&) {
+        return KUZNETSOV_ENOMEM;
+      }
+      return KUZNETSOV_OK;
+    }
+  }
+}
+
+unsigned kuznetsov_capiVersion(void)
+{
+  return KUZNETSOV_CAPI_VERSION;
+}
+
+int kuznetsov_getCntColNsm(const int* mtx, size_t stride, size_t rows, size_t cols, int* result)
+{
+  return kuznetsov::callDense(kuznetsov::getCntColNsm, mtx, stride, rows, cols, result);
+}
+
+int kuznetsov_getCntLocMax(const int* mtx, size_t stride, size_t rows, size_t cols, int* result)
+{
+  return kuznetsov::callDense(kuznetsov::getCntLocMax, mtx, stride, rows, cols, result);
+}
@@ -0,0 +1,26 @@
+#ifndef KUZNETSOV_CAPI_H
+#define KUZNETSOV_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KUZNETSOV_CAPI_VERSION 1
+
+#define KUZNETSOV_OK 0
+#define KUZNETSOV_EINVAL 1
+#define KUZNETSOV_ENOMEM 3
+
+/* Read-only row-major matrices; row i begins at mtx + i * stride, stride >= cols. */
+
+unsigned kuznetsov_capiVersion(void);
+int kuznetsov_getCntColNsm(const int* mtx, size_t stride, size_t rows, size_t cols, int* result);
+int kuznetsov_getCntLocMax(const int* mtx, size_t stride, size_t rows, size_t cols, int* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
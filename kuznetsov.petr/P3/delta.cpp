@@ -0,0 +1,170 @@
+#include "delta.hpp"
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include "parallel.hpp"
+
+namespace kuznetsov {
+  namespace {
+    const char DELTA_MAGIC[8] = {'K', 'Z', 'D', 'E', 'L', 'T', 'A', '1'};
+
+    template< class T >
+    bool readPod(std::istream& in, T& value)
+    {
+      return static_cast< bool >(in.read(reinterpret_cast< char* >(&value), sizeof(T)));
+    }
+
+    template< class T >
+    void writePod(std::ostream& out, const T& value)
+    {
+      out.write(reinterpret_cast< const char* >(&value), sizeof(T));
+    }
+
+    void findRepeats(const int* upper, const int* lower, size_t cols, std::vector< uint32_t >& res)
+    {
+      res.clear();
+      for (size_t j = 0; j < cols; ++j) {
+        if (upper[j] == lower[j]) {
+          res.push_back(static_cast< uint32_t >(j));
+        }
+      }
+    }
+  }
+}
+
+uint64_t kuznetsov::hashRow(const int* row, size_t cols)
+{
+  const size_t LANES = 8;
+  uint32_t acc[LANES] = {
+    0x243F6A88u, 0x85A308D3u, 0x13198A2Eu, 0x03707344u,
+    0xA4093822u, 0x299F31D0u, 0x082EFA98u, 0xEC4E6C89u
+  };
+  size_t j = 0;
+  for (; j + LANES <= cols; j += LANES) {
+    for (size_t k = 0; k < LANES; ++k) {
+      uint32_t v = acc[k] ^ static_cast< uint32_t >(row[j + k]);
+      v *= 0x9E3779B1u;
+      acc[k] = v ^ (v >> 15);
+    }
+  }
+  for (size_t k = 0; j < cols; ++j, ++k) {
+    uint32_t v = acc[k] ^ static_cast< uint32_t >(row[j]);
+    v *= 0x9E3779B1u;
+    acc[k] = v ^ (v >> 15);
+  }
+  uint64_t h = cols;
+  for (size_t k = 0; k < LANES; ++k) {
+    h = (h ^ acc[k]) * 0x100000001B3ull;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+bool kuznetsov::loadDelta(const char* path, DeltaState& state)
+{
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(DELTA_MAGIC)] = {};
+  uint64_t rows = 0, cols = 0;
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, DELTA_MAGIC, sizeof(magic)) != 0) {
+    return false;
+  }
+  if (!readPod(in, rows) || !readPod(in, cols)) {
+    return false;
+  }
+  // every row stores a hash and a count, and every row pair at least a
+  // repeat count, so a header with more rows than the file can hold is
+  // corrupt and must not size the vectors
+  std::streamoff start = in.tellg();
+  in.seekg(0, std::ios::end);
+  std::streamoff end = in.tellg();
+  in.seekg(start);
+  uint64_t left = (start < 0 || end < start) ? 0 : static_cast< uint64_t >(end - start);
+  const uint64_t rowSize = sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t);
+  if (rows > (left + sizeof(uint32_t)) / rowSize || cols > UINT32_MAX) {
+    return false;
+  }
+  DeltaState res{rows, cols, std::vector< uint64_t >(rows), std::vector< int >(rows), {}};
+  for (size_t i = 0; i < rows; ++i) {
+    int32_t cnt = 0;
+    if (!readPod(in, res.hashes[i]) || !readPod(in, cnt)) {
+      return false;
+    }
+    res.locMax[i] = cnt;
+  }
+  res.repeats.resize(rows ? rows - 1 : 0);
+  for (std::vector< uint32_t >& pair: res.repeats) {
+    uint32_t cnt = 0;
+    if (!readPod(in, cnt) || cnt > cols) {
+      return false;
+    }
+    pair.resize(cnt);
+    if (cnt && !in.read(reinterpret_cast< char* >(pair.data()), sizeof(uint32_t) * cnt)) {
+      return false;
+    }
+    for (uint32_t j: pair) {
+      if (j >= cols) {
+        return false;
+      }
+    }
+  }
+  state = std::move(res);
+  return true;
+}
+
+bool kuznetsov::saveDelta(const char* path, const DeltaState& state)
+{
+  std::ofstream out(path, std::ios::binary);
+  out.write(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+  writePod(out, static_cast< uint64_t >(state.rows));
+  writePod(out, static_cast< uint64_t >(state.cols));
+  for (size_t i = 0; i < state.rows; ++i) {
+    writePod(out, state.hashes[i]);
+    writePod(out, static_cast< int32_t >(state.locMax[i]));
+  }
+  for (const std::vector< uint32_t >& pair: state.repeats) {
+    writePod(out, static_cast< uint32_t >(pair.size()));
+    out.write(reinterpret_cast< const char* >(pair.data()), sizeof(uint32_t) * pair.size());
+  }
+  return static_cast< bool >(out);
+}
+
+kuznetsov::DeltaResult kuznetsov::reloadDelta(const int* mtx, size_t rows, size_t cols, DeltaState& state)
+{
+  bool fresh = state.rows != rows || state.cols != cols || state.hashes.size() != rows;
+  if (fresh) {
+    state.rows = rows;
+    state.cols = cols;
+    state.hashes.assign(rows, 0);
+    state.locMax.assign(rows, 0);
+    state.repeats.assign(rows ? rows - 1 : 0, {});
+  }
+  DeltaResult res{0, 0, 0};
+  std::vector< char > changed(rows, fresh);
+  for (size_t i = 0; i < rows; ++i) {
+    uint64_t h = hashRow(mtx + i * cols, cols);
+    changed[i] = changed[i] || h != state.hashes[i];
+    state.hashes[i] = h;
+    res.changedRows += changed[i];
+  }
+  for (size_t i = 1; i + 1 < rows; ++i) {
+    if (changed[i - 1] || changed[i] || changed[i + 1]) {
+      state.locMax[i] = cntLocMaxRows(mtx, rows, cols, i, i + 1);
+    }
+    res.cntLocMax += state.locMax[i];
+  }
+  std::vector< char > repeats(cols, 0);
+  for (size_t i = 0; i + 1 < rows; ++i) {
+    if (changed[i] || changed[i + 1]) {
+      findRepeats(mtx + i * cols, mtx + (i + 1) * cols, cols, state.repeats[i]);
+    }
+    for (uint32_t j: state.repeats[i]) {
+      repeats[j] = 1;
+    }
+  }
+  if (rows && cols) {
+    for (size_t j = 0; j < cols; ++j) {
+      res.cntColNsm += !repeats[j];
+    }
+  }
+  return res;
+}
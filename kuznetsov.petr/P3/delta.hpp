@@ -0,0 +1,31 @@
+#ifndef KUZNETSOV_DELTA_HPP
+#define KUZNETSOV_DELTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kuznetsov {
+  // Per-row contributions saved between runs. Only rows whose hash
+  // changed (plus their halo) are recomputed on the next reload.
+  struct DeltaState {
+    size_t rows;
+    size_t cols;
+    std::vector< uint64_t > hashes;
+    std::vector< int > locMax;
+    std::vector< std::vector< uint32_t > > repeats;
+  };
+
+  struct DeltaResult {
+    int cntColNsm;
+    int cntLocMax;
+    size_t changedRows;
+  };
+
+  uint64_t hashRow(const int* row, size_t cols);
+  bool loadDelta(const char* path, DeltaState& state);
+  bool saveDelta(const char* path, const DeltaState& state);
+  DeltaResult reloadDelta(const int* mtx, size_t rows, size_t cols, DeltaState& state);
+}
+
+#endif
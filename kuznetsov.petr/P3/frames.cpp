@@ -0,0 +1,95 @@
+#include "frames.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+void kuznetsov::initFrames(FrameWindow& win, size_t rows, size_t cols)
+{
+  win.rows = rows;
+  win.cols = cols;
+  win.count = 0;
+  if (cols && rows > win.values[0].max_size() / cols) {
+    throw std::length_error("Frame is too large");
+  }
+  for (size_t k = 0; k < 2; ++k) {
+    win.values[k].assign(rows * cols, 0);
+    win.rowMax[k].assign(rows * cols, 0);
+  }
+  for (size_t k = 0; k < 3; ++k) {
+    win.boxMax[k].assign(rows * cols, 0);
+  }
+}
+
+int* kuznetsov::nextFrame(FrameWindow& win)
+{
+  return win.values[win.count % 2].data();
+}
+
+bool kuznetsov::pushFrame(FrameWindow& win)
+{
+  size_t k = win.count % 2;
+  getRowMax(win.values[k].data(), win.rows, win.cols, win.rowMax[k].data());
+  getBoxMax(win.rowMax[k].data(), win.rows, win.cols, win.boxMax[win.count % 3].data());
+  ++win.count;
+  return win.count >= 3;
+}
+
+int kuznetsov::getCntLocMax3d(const FrameWindow& win)
+{
+  const size_t rows = win.rows;
+  const size_t cols = win.cols;
+  if (win.count < 3 || rows < 3 || cols < 3) {
+    return 0;
+  }
+  const int* prev = win.boxMax[(win.count - 3) % 3].data();
+  const int* next = win.boxMax[(win.count - 1) % 3].data();
+  const int* mtx = win.values[(win.count - 2) % 2].data();
+  const int* rowMax = win.rowMax[(win.count - 2) % 2].data();
+  int res = 0;
+  for (size_t i = 1; i < rows - 1; ++i) {
+    for (size_t j = 1; j < cols - 1; ++j) {
+      size_t id = i * cols + j;
+      int around = std::max(std::max(prev[id], next[id]), std::max(rowMax[id - cols], rowMax[id + cols]));
+      around = std::max(around, std::max(mtx[id - 1], mtx[id + 1]));
+      res += mtx[id] > around;
+    }
+  }
+  return res;
+}
+
+void kuznetsov::getRowMax(const int* mtx, size_t rows, size_t cols, int* rowMax)
+{
+  if (cols < 3) {
+    return;
+  }
+  for (size_t i = 0; i < rows; ++i) {
+    const int* row = mtx + i * cols;
+    int* out = rowMax + i * cols;
+    for (size_t j = 1; j < cols - 1; ++j) {
+      out[j] = std::max(std::max(row[j - 1], row[j]), row[j + 1]);
+    }
+  }
+}
+
+void kuznetsov::getBoxMax(const int* rowMax, size_t rows, size_t cols, int* boxMax)
+{
+  if (rows < 3 || cols < 3) {
+    return;
+  }
+  for (size_t i = 1; i < rows - 1; ++i) {
+    const int* up = rowMax + (i - 1) * cols;
+    const int* row = rowMax + i * cols;
+    const int* down = rowMax + (i + 1) * cols;
+    int* out = boxMax + i * cols;
+    for (size_t j = 1; j < cols - 1; ++j) {
+      out[j] = std::max(std::max(up[j], row[j]), down[j]);
+    }
+  }
+}
+
+std::istream& kuznetsov::readFrame(std::istream& input, int* mtx, size_t rows, size_t cols)
+{
+  for (size_t i = 0; input && i < rows * cols; ++i) {
+    input >> mtx[i];
+  }
+  return input;
+}
@@ -0,0 +1,32 @@
+#ifndef KUZNETSOV_FRAMES_HPP
+#define KUZNETSOV_FRAMES_HPP
+
+#include <cstddef>
+#include <istream>
+#include <vector>
+
+namespace kuznetsov {
+  // Sliding window over a time sequence of frames. A 26-neighbour peak
+  // test of the middle frame reads its values and 3-wide row maxima and
+  // the 3x3 box maxima of the frames around it, so values and row maxima
+  // are kept for the two newest frames and box maxima for the last three.
+  struct FrameWindow {
+    size_t rows;
+    size_t cols;
+    size_t count;
+    std::vector< int > values[2];
+    std::vector< int > rowMax[2];
+    std::vector< int > boxMax[3];
+  };
+
+  void initFrames(FrameWindow& win, size_t rows, size_t cols);
+  int* nextFrame(FrameWindow& win);
+  bool pushFrame(FrameWindow& win);
+  int getCntLocMax3d(const FrameWindow& win);
+
+  void getRowMax(const int* mtx, size_t rows, size_t cols, int* rowMax);
+  void getBoxMax(const int* rowMax, size_t rows, size_t cols, int* boxMax);
+  std::istream& readFrame(std::istream& input, int* mtx, size_t rows, size_t cols);
+}
+
+#endif
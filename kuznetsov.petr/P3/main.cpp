@@ -2,21 +2,73 @@
 #include <fstream>
 #include <memory>
 #include <cctype>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include "bench.hpp"
+#include "delta.hpp"
+#include "frames.hpp"
+#include "matrix.hpp"
+#include "packed.hpp"
+#include "parallel.hpp"
+#include "shard.hpp"
+#include "trace.hpp"
+#include "tuning.hpp"
 
 namespace kuznetsov {
   const size_t MAX_SIZE = 10'000;
 
-  int getCntColNsm(const int* mtx, size_t rows, size_t cols);
-  int getCntLocMax(const int* mtx, size_t rows, size_t cols);
-
   std::istream& initMatr(std::istream& input, int* mtx, size_t rows, size_t cols);
 
   int processMatrix(std::istream& input, int* mtx, size_t rows, size_t cols, const char* out);
+  int processPacked(std::istream& input, size_t rows, size_t cols, const char* out);
+  int processSharded(std::istream& input, size_t rows, size_t cols, const char* out);
+  int processFrames(std::istream& input, size_t rows, size_t cols, const char* out);
 }
 
 int main(int argc, char** argv)
 {
   namespace kuz = kuznetsov;
+  if (const char* bench = std::getenv("KUZNETSOV_BENCH")) {
+    const char* samples = std::getenv("KUZNETSOV_BENCH_SAMPLES");
+    size_t count = samples ? std::strtoul(samples, nullptr, 10) : 0;
+    std::ofstream output(bench);
+    kuz::writeBench(output, kuz::runBench(count ? count : 20));
+    if (!output) {
+      std::cerr << "Can't write benchmark results\n";
+      return 2;
+    }
+    return 0;
+  }
+  if (const char* effect = std::getenv("KUZNETSOV_BENCH_COMPARE")) {
+    if (argc != 3) {
+      std::cerr << "Compare needs two result files\n";
+      return 1;
+    }
+    std::ifstream before(argv[1]);
+    std::ifstream after(argv[2]);
+    double minEffect = *effect ? std::strtod(effect, nullptr) : 0.05;
+    int status = kuz::compareBench(before, after, std::cout, minEffect);
+    if (status == 2) {
+      std::cerr << "Bad benchmark results\n";
+    }
+    return status;
+  }
+  if (const char* profile = std::getenv("KUZNETSOV_AUTOTUNE")) {
+    kuz::TuningProfile prof = kuz::autotune(1024, 1024);
+    if (!kuz::saveTuning(profile, prof)) {
+      std::cerr << "Can't write tuning profile\n";
+      return 2;
+    }
+    return 0;
+  }
+  if (const char* coordinator = std::getenv("KUZNETSOV_SHARD_WORKER")) {
+    if (!kuz::runShardWorker(coordinator)) {
+      std::cerr << "Shard worker failed\n";
+      return 2;
+    }
+    return 0;
+  }
   if (argc < 4) {
     std::cerr << "Not enough arguments\n";
     return 1;
@@ -44,6 +96,15 @@ int main(int argc, char** argv)
     std::cerr << "Bad reading size\n";
     return 2;
   }
+  if (std::getenv("KUZNETSOV_PACKED")) {
+    return kuz::processPacked(input, rows, cols, argv[3]);
+  }
+  if (std::getenv("KUZNETSOV_SHARDS")) {
+    return kuz::processSharded(input, rows, cols, argv[3]);
+  }
+  if (std::getenv("KUZNETSOV_FRAMES")) {
+    return kuz::processFrames(input, rows, cols, argv[3]);
+  }
   int mtx[kuz::MAX_SIZE] {};
   int* mtrx = nullptr;
   int* mt = nullptr;
@@ -62,73 +123,182 @@ int main(int argc, char** argv)
   return statusExit;
 }
 
-int kuznetsov::getCntColNsm(const int* mtx, size_t rows, size_t cols)
+std::istream& kuznetsov::initMatr(std::istream& input, int* mtx, size_t rows, size_t cols)
 {
-  if (rows == 0 || cols == 0) {
-    return 0;
-  }
-  int res = 0;
-  for (size_t j = 0; j < cols; ++j) {
-    bool repeats = false;
-    for (size_t i = 0; i < rows - 1; ++i) {
-      if (mtx[i * cols + j] == mtx[(i + 1) * cols + j]) {
-        repeats = true;
-        break;
-      }
-    }
-    res += !repeats;
+  for (size_t i = 0; input && i < rows * cols; ++i) {
+    input >> mtx[i];
   }
-  return res;
+  return input;
 }
 
-int kuznetsov::getCntLocMax(const int* mtx, size_t rows, size_t cols)
+int kuznetsov::processMatrix(std::istream& input, int* mtx, size_t rows, size_t cols, const char* out)
 {
-  if (rows == 0 || cols == 0) {
-    return 0;
+  {
+    TraceSpan span("stage", "parse");
+    initMatr(input, mtx, rows, cols);
   }
-  int res = 0;
-  for (size_t j = 1; j < cols - 1; ++j) {
-    for (size_t i = 1; i < rows - 1; ++i) {
-      int center = mtx[i * cols + j];
-      bool isLocMax = true;
-      for (int di = -1; di <= 1; ++di) {
-        for (int dj = -1; dj <= 1; ++dj) {
-          if (!(di == 0 && dj == 0)) {
-            isLocMax = isLocMax && (center > mtx[(i + di) * cols + j + dj]);
-          }
-        }
-      }
-      res += isLocMax;
+  if (input.eof()) {
+    std::cerr << "Not enough elements for matrix\n";
+    return 1;
+  } else if (input.fail()) {
+    std::cerr << "Bad read\n";
+    return 2;
+  }
+
+  int res1 = 0;
+  int res2 = 0;
+  int status = 0;
+  const char* deltaPath = std::getenv("KUZNETSOV_DELTA");
+  if (deltaPath) {
+    TraceSpan span("stage", "delta reload");
+    DeltaState state{0, 0, {}, {}, {}};
+    loadDelta(deltaPath, state);
+    DeltaResult delta = reloadDelta(mtx, rows, cols, state);
+    if (!saveDelta(deltaPath, state)) {
+      std::cerr << "Can't write delta state\n";
+      status = 2;
     }
+    res1 = delta.cntColNsm;
+    res2 = delta.cntLocMax;
+  } else {
+    {
+      TraceSpan span("stage", "getCntColNsm");
+      size_t tile = getColTile();
+      res1 = tile ? getCntColNsmTiled(mtx, rows, cols, tile) : getCntColNsm(mtx, rows, cols);
+    }
+    TraceSpan span("stage", "getCntLocMax");
+    BandConfig conf = getBandConfig(rows);
+    res2 = conf.threads > 1 ? getCntLocMaxBands(mtx, rows, cols, conf) : getCntLocMax(mtx, rows, cols);
   }
-  return res;
+
+  TraceSpan span("stage", "write");
+  std::ofstream output(out);
+  output << res1 << '\n';
+  output << res2 << '\n';
+
+  return status;
 }
 
-std::istream& kuznetsov::initMatr(std::istream& input, int* mtx, size_t rows, size_t cols)
+int kuznetsov::processPacked(std::istream& input, size_t rows, size_t cols, const char* out)
 {
-  for (size_t i = 0; input && i < rows * cols; ++i) {
-    input >> mtx[i];
+  PackedMatrix mtx{0, 0, 0, {}, {}, {}, {}};
+  try {
+    TraceSpan span("stage", "parse packed");
+    readPacked(input, mtx, rows, cols);
+  } catch (const std::bad_alloc&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
+  } catch (const std::length_error&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
   }
-  return input;
+  if (input.eof()) {
+    std::cerr << "Not enough elements for matrix\n";
+    return 1;
+  } else if (input.fail()) {
+    std::cerr << "Bad read\n";
+    return 2;
+  }
+
+  int res1 = 0;
+  int res2 = 0;
+  {
+    TraceSpan span("stage", "getCntColNsmPacked");
+    res1 = getCntColNsmPacked(mtx);
+  }
+  {
+    TraceSpan span("stage", "getCntLocMaxPacked");
+    res2 = getCntLocMaxPacked(mtx);
+  }
+
+  TraceSpan span("stage", "write");
+  std::ofstream output(out);
+  output << res1 << '\n';
+  output << res2 << '\n';
+
+  return 0;
 }
 
-int kuznetsov::processMatrix(std::istream& input, int* mtx, size_t rows, size_t cols, const char* out)
+int kuznetsov::processSharded(std::istream& input, size_t rows, size_t cols, const char* out)
 {
-  initMatr(input, mtx, rows, cols);
+  ShardPlan plan = getShardPlan(std::getenv("KUZNETSOV_SHARDS"), std::getenv("KUZNETSOV_SHARD_TRANSPORT"), std::getenv("KUZNETSOV_SHARD_LISTEN"));
+  ShardResult res{0, 0};
+  bool ok = false;
+  try {
+    ok = runSharded(input, rows, cols, plan, res);
+  } catch (const std::bad_alloc&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
+  } catch (const std::length_error&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
+  }
   if (input.eof()) {
     std::cerr << "Not enough elements for matrix\n";
     return 1;
   } else if (input.fail()) {
     std::cerr << "Bad read\n";
     return 2;
+  } else if (!ok) {
+    std::cerr << "Shard worker failed\n";
+    return 2;
   }
 
-  int res1 = getCntColNsm(mtx, rows, cols);
-  int res2 = getCntLocMax(mtx, rows, cols);
+  TraceSpan span("stage", "write");
+  std::ofstream output(out);
+  output << res.cntColNsm << '\n';
+  output << res.cntLocMax << '\n';
 
+  return 0;
+}
+
+int kuznetsov::processFrames(std::istream& input, size_t rows, size_t cols, const char* out)
+{
+  FrameWindow win{0, 0, 0, {}, {}, {}};
+  try {
+    initFrames(win, rows, cols);
+  } catch (const std::bad_alloc&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
+  } catch (const std::length_error&) {
+    std::cerr << "Bad alloc\n";
+    return 3;
+  }
   std::ofstream output(out);
-  output << res1 << '\n';
-  output << res2 << '\n';
+  size_t frameRows = rows, frameCols = cols;
+  while (true) {
+    {
+      TraceSpan span("stage", "parse frame");
+      readFrame(input, nextFrame(win), rows, cols);
+    }
+    if (input.fail() && input.eof()) {
+      std::cerr << "Not enough elements for matrix\n";
+      return 1;
+    } else if (input.fail()) {
+      std::cerr << "Bad read\n";
+      return 2;
+    }
+    {
+      TraceSpan span("stage", "getCntLocMax3d");
+      if (pushFrame(win)) {
+        output << getCntLocMax3d(win) << '\n';
+      } else if (win.count == 1) {
+        output << 0 << '\n';
+      }
+    }
+    if (!(input >> frameRows) && input.eof()) {
+      break;
+    } else if (!(input >> frameCols)) {
+      std::cerr << "Bad reading size\n";
+      return 2;
+    } else if (frameRows != rows || frameCols != cols) {
+      std::cerr << "Frame size mismatch\n";
+      return 2;
+    }
+  }
 
+  if (win.count > 1) {
+    output << 0 << '\n';
+  }
   return 0;
 }
@@ -0,0 +1,11 @@
+#ifndef KUZNETSOV_MATRIX_HPP
+#define KUZNETSOV_MATRIX_HPP
+
+#include <cstddef>
+
+namespace kuznetsov {
+  int getCntColNsm(const int* mtx, size_t rows, size_t cols);
+  int getCntLocMax(const int* mtx, size_t rows, size_t cols);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include "packed.hpp"
+#include <algorithm>
+
+namespace kuznetsov {
+  namespace {
+    uint32_t extract(const uint64_t* words, unsigned width, size_t k)
+    {
+      size_t bit = k * width;
+      unsigned shift = bit & 63;
+      uint64_t v = words[bit >> 6] >> shift;
+      if (shift + width > 64) {
+        v |= words[(bit >> 6) + 1] << (64 - shift);
+      }
+      return static_cast< uint32_t >(v & ((uint64_t(1) << width) - 1));
+    }
+
+    size_t blockSize(const PackedMatrix& mtx, size_t block)
+    {
+      return std::min(PACK_BLOCK, mtx.cols - block * PACK_BLOCK);
+    }
+
+    void unpackHalo(const PackedMatrix& mtx, size_t row, size_t block, int* out)
+    {
+      size_t begin = block * PACK_BLOCK;
+      size_t n = blockSize(mtx, block);
+      out[0] = begin > 0 ? getPacked(mtx, row, begin - 1) : 0;
+      unpackBlock(mtx, row, block, out + 1);
+      out[n + 1] = begin + n < mtx.cols ? getPacked(mtx, row, begin + n) : 0;
+    }
+  }
+}
+
+void kuznetsov::initPacked(PackedMatrix& mtx, size_t rows, size_t cols)
+{
+  mtx.rows = 0;
+  mtx.cols = cols;
+  mtx.blocksPerRow = (cols + PACK_BLOCK - 1) / PACK_BLOCK;
+  mtx.bases.clear();
+  mtx.widths.clear();
+  mtx.offsets.clear();
+  mtx.words.clear();
+  mtx.bases.reserve(rows * mtx.blocksPerRow);
+  mtx.widths.reserve(rows * mtx.blocksPerRow);
+  mtx.offsets.reserve(rows * mtx.blocksPerRow);
+}
+
+void kuznetsov::packRow(PackedMatrix& mtx, const int* row)
+{
+  for (size_t b = 0; b < mtx.blocksPerRow; ++b) {
+    const int* values = row + b * PACK_BLOCK;
+    size_t n = blockSize(mtx, b);
+    int lo = *std::min_element(values, values + n);
+    int hi = *std::max_element(values, values + n);
+    uint32_t span = static_cast< uint32_t >(hi) - static_cast< uint32_t >(lo);
+    unsigned width = 0;
+    while (width < 32 && (span >> width) != 0) {
+      ++width;
+    }
+    size_t offset = mtx.words.size();
+    mtx.bases.push_back(lo);
+    mtx.widths.push_back(static_cast< uint8_t >(width));
+    mtx.offsets.push_back(offset);
+    mtx.words.resize(offset + 2 * width, 0);
+    uint64_t* words = mtx.words.data() + offset;
+    for (size_t k = 0; width && k < n; ++k) {
+      uint64_t v = static_cast< uint32_t >(values[k]) - static_cast< uint32_t >(lo);
+      size_t bit = k * width;
+      unsigned shift = bit & 63;
+      words[bit >> 6] |= v << shift;
+      if (shift + width > 64) {
+        words[(bit >> 6) + 1] |= v >> (64 - shift);
+      }
+    }
+  }
+  ++mtx.rows;
+}
+
+void kuznetsov::unpackBlock(const PackedMatrix& mtx, size_t row, size_t block, int* out)
+{
+  size_t id = row * mtx.blocksPerRow + block;
+  size_t n = blockSize(mtx, block);
+  uint32_t base = static_cast< uint32_t >(mtx.bases[id]);
+  unsigned width = mtx.widths[id];
+  if (width == 0) {
+    std::fill(out, out + n, mtx.bases[id]);
+    return;
+  }
+  const uint64_t* words = mtx.words.data() + mtx.offsets[id];
+  for (size_t k = 0; k < n; ++k) {
+    out[k] = static_cast< int >(base + extract(words, width, k));
+  }
+}
+
+int kuznetsov::getPacked(const PackedMatrix& mtx, size_t row, size_t col)
+{
+  size_t id = row * mtx.blocksPerRow + col / PACK_BLOCK;
+  unsigned width = mtx.widths[id];
+  uint32_t base = static_cast< uint32_t >(mtx.bases[id]);
+  if (width == 0) {
+    return mtx.bases[id];
+  }
+  return static_cast< int >(base + extract(mtx.words.data() + mtx.offsets[id], width, col % PACK_BLOCK));
+}
+
+std::istream& kuznetsov::readPacked(std::istream& input, PackedMatrix& mtx, size_t rows, size_t cols)
+{
+  initPacked(mtx, rows, cols);
+  std::vector< int > row(cols);
+  for (size_t i = 0; input && i < rows; ++i) {
+    for (size_t j = 0; input && j < cols; ++j) {
+      input >> row[j];
+    }
+    if (input) {
+      packRow(mtx, row.data());
+    }
+  }
+  return input;
+}
+
+int kuznetsov::getCntColNsmPacked(const PackedMatrix& mtx)
+{
+  if (mtx.rows == 0 || mtx.cols == 0) {
+    return 0;
+  }
+  int res = 0;
+  int prev[PACK_BLOCK];
+  int curr[PACK_BLOCK];
+  for (size_t b = 0; b < mtx.blocksPerRow; ++b) {
+    size_t n = blockSize(mtx, b);
+    bool repeats[PACK_BLOCK] = {};
+    unpackBlock(mtx, 0, b, prev);
+    for (size_t i = 1; i < mtx.rows; ++i) {
+      unpackBlock(mtx, i, b, curr);
+      for (size_t k = 0; k < n; ++k) {
+        repeats[k] = repeats[k] || curr[k] == prev[k];
+      }
+      std::copy(curr, curr + n, prev);
+    }
+    for (size_t k = 0; k < n; ++k) {
+      res += !repeats[k];
+    }
+  }
+  return res;
+}
+
+int kuznetsov::getCntLocMaxPacked(const PackedMatrix& mtx)
+{
+  if (mtx.rows < 3 || mtx.cols < 3) {
+    return 0;
+  }
+  int res = 0;
+  int scratch[3][PACK_BLOCK + 2];
+  for (size_t b = 0; b < mtx.blocksPerRow; ++b) {
+    size_t begin = b * PACK_BLOCK;
+    size_t n = blockSize(mtx, b);
+    size_t from = std::max< size_t >(begin, 1) - begin + 1;
+    size_t to = std::min(begin + n, mtx.cols - 1) - begin + 1;
+    int* up = scratch[0];
+    int* mid = scratch[1];
+    int* down = scratch[2];
+    unpackHalo(mtx, 0, b, up);
+    unpackHalo(mtx, 1, b, mid);
+    for (size_t i = 1; i + 1 < mtx.rows; ++i) {
+      unpackHalo(mtx, i + 1, b, down);
+      for (size_t k = from; k < to; ++k) {
+        int center = mid[k];
+        bool isLocMax = center > up[k - 1] && center > up[k] && center > up[k + 1];
+        isLocMax = isLocMax && center > mid[k - 1] && center > mid[k + 1];
+        isLocMax = isLocMax && center > down[k - 1] && center > down[k] && center > down[k + 1];
+        res += isLocMax;
+      }
+      std::swap(up, mid);
+      std::swap(mid, down);
+    }
+  }
+  return res;
+}
@@ -0,0 +1,35 @@
+#ifndef KUZNETSOV_PACKED_HPP
+#define KUZNETSOV_PACKED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+namespace kuznetsov {
+  const size_t PACK_BLOCK = 128;
+
+  // Frame-of-reference storage: every row is cut into blocks of
+  // PACK_BLOCK values, each stored as offsets from the block minimum
+  // with its own bit width.
+  struct PackedMatrix {
+    size_t rows;
+    size_t cols;
+    size_t blocksPerRow;
+    std::vector< int > bases;
+    std::vector< uint8_t > widths;
+    std::vector< size_t > offsets;
+    std::vector< uint64_t > words;
+  };
+
+  void initPacked(PackedMatrix& mtx, size_t rows, size_t cols);
+  void packRow(PackedMatrix& mtx, const int* row);
+  void unpackBlock(const PackedMatrix& mtx, size_t row, size_t block, int* out);
+  int getPacked(const PackedMatrix& mtx, size_t row, size_t col);
+
+  std::istream& readPacked(std::istream& input, PackedMatrix& mtx, size_t rows, size_t cols);
+  int getCntColNsmPacked(const PackedMatrix& mtx);
+  int getCntLocMaxPacked(const PackedMatrix& mtx);
+}
+
+#endif
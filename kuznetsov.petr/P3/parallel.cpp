@@ -0,0 +1,149 @@
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "trace.hpp"
+#include "tuning.hpp"
+
+namespace kuznetsov {
+  namespace {
+    size_t getEnvSize(const char* name, size_t def)
+    {
+      const char* value = std::getenv(name);
+      if (!value || !*value) {
+        return def;
+      }
+      char* end = nullptr;
+      unsigned long long res = std::strtoull(value, &end, 10);
+      return *end == '\0' ? static_cast< size_t >(res) : def;
+    }
+
+    struct BandQueue {
+      const int* mtx;
+      size_t rows;
+      size_t cols;
+      size_t bandRows;
+      size_t bands;
+      uint64_t enqueued;
+      std::atomic< size_t > next;
+      std::atomic< int > res;
+    };
+
+    void runBands(BandQueue& q)
+    {
+      int local = 0;
+      for (size_t band = q.next.fetch_add(1); band < q.bands; band = q.next.fetch_add(1)) {
+        if (traceEnabled()) {
+          traceRecord("queue", "band wait", q.enqueued, traceNow());
+        }
+        TraceSpan span("task", "locmax band");
+        size_t begin = 1 + band * q.bandRows;
+        size_t end = std::min(begin + q.bandRows, q.rows - 1);
+        local += cntLocMaxRows(q.mtx, q.rows, q.cols, begin, end);
+      }
+      q.res += local;
+    }
+  }
+}
+
+kuznetsov::BandConfig kuznetsov::getBandConfig(size_t rows)
+{
+  const TuningProfile& prof = getTuning();
+  BandConfig conf{getEnvSize("KUZNETSOV_THREADS", prof.threads), getEnvSize("KUZNETSOV_BAND", prof.bandRows)};
+  if (conf.threads == 0) {
+    conf.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (conf.bandRows == 0) {
+    size_t inner = rows > 2 ? rows - 2 : 1;
+    conf.bandRows = std::max< size_t >(1, inner / (conf.threads * 4));
+  }
+  return conf;
+}
+
+size_t kuznetsov::getColTile()
+{
+  return getEnvSize("KUZNETSOV_COL_TILE", getTuning().colTile);
+}
+
+int kuznetsov::cntLocMaxRows(const int* mtx, size_t rows, size_t cols, size_t begin, size_t end)
+{
+  if (rows < 3 || cols < 3) {
+    return 0;
+  }
+  int res = 0;
+  for (size_t i = begin; i < end; ++i) {
+    const int* up = mtx + (i - 1) * cols;
+    const int* mid = mtx + i * cols;
+    const int* down = mtx + (i + 1) * cols;
+    for (size_t j = 1; j < cols - 1; ++j) {
+      int center = mid[j];
+      bool isLocMax = center > up[j - 1] && center > up[j] && center > up[j + 1];
+      isLocMax = isLocMax && center > mid[j - 1] && center > mid[j + 1];
+      isLocMax = isLocMax && center > down[j - 1] && center > down[j] && center > down[j + 1];
+      res += isLocMax;
+    }
+  }
+  return res;
+}
+
+int kuznetsov::getCntLocMaxBands(const int* mtx, size_t rows, size_t cols, BandConfig conf)
+{
+  if (rows < 3 || cols < 3) {
+    return 0;
+  }
+  size_t bandRows = std::max< size_t >(1, conf.bandRows);
+  BandQueue q{mtx, rows, cols, bandRows, (rows - 2 + bandRows - 1) / bandRows, traceNow(), {0}, {0}};
+  std::vector< std::thread > workers;
+  size_t threads = std::min(conf.threads, q.bands);
+  try {
+    for (size_t t = 1; t < threads; ++t) {
+      workers.emplace_back([&q]()
+      {
+        traceThreadName("locmax worker");
+        runBands(q);
+      });
+    }
+  } catch (const std::system_error&) {
+  }
+  traceThreadName("main");
+  runBands(q);
+  {
+    TraceSpan span("worker", "join");
+    for (std::thread& w: workers) {
+      w.join();
+    }
+  }
+  return q.res;
+}
+
+int kuznetsov::getCntColNsmTiled(const int* mtx, size_t rows, size_t cols, size_t tile)
+{
+  if (rows == 0 || cols == 0) {
+    return 0;
+  }
+  if (tile == 0) {
+    tile = 1;
+  }
+  int res = 0;
+  std::vector< char > repeats(std::min(tile, cols));
+  for (size_t begin = 0; begin < cols; begin += tile) {
+    size_t n = std::min(tile, cols - begin);
+    std::fill(repeats.begin(), repeats.begin() + n, 0);
+    size_t left = n;
+    for (size_t i = 0; left && i + 1 < rows; ++i) {
+      const int* upper = mtx + i * cols + begin;
+      const int* lower = upper + cols;
+      for (size_t k = 0; k < n; ++k) {
+        bool eq = upper[k] == lower[k];
+        left -= eq && !repeats[k];
+        repeats[k] |= eq;
+      }
+    }
+    res += static_cast< int >(left);
+  }
+  return res;
+}
@@ -0,0 +1,20 @@
+#ifndef KUZNETSOV_PARALLEL_HPP
+#define KUZNETSOV_PARALLEL_HPP
+
+#include <cstddef>
+
+namespace kuznetsov {
+  struct BandConfig {
+    size_t threads;
+    size_t bandRows;
+  };
+
+  BandConfig getBandConfig(size_t rows);
+  size_t getColTile();
+
+  int cntLocMaxRows(const int* mtx, size_t rows, size_t cols, size_t begin, size_t end);
+  int getCntLocMaxBands(const int* mtx, size_t rows, size_t cols, BandConfig conf);
+  int getCntColNsmTiled(const int* mtx, size_t rows, size_t cols, size_t tile);
+}
+
+#endif
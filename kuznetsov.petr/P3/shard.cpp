@@ -0,0 +1,423 @@
+#include "shard.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace kuznetsov {
+  namespace {
+    struct BandHeader {
+      uint64_t begin;
+      uint64_t end;
+      uint64_t rows;
+      uint64_t cols;
+    };
+
+    // Where a networked worker accepts its upper halo link, and which
+    // neighbours it has. Address and port are in network byte order.
+    struct PeerAddress {
+      uint32_t addr;
+      uint16_t port;
+      uint16_t reserved;
+    };
+
+    struct LinkPlan {
+      uint32_t downAddr;
+      uint16_t downPort;
+      uint8_t hasUp;
+      uint8_t hasDown;
+    };
+
+    void closeFd(int& fd)
+    {
+      if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+
+    bool sendAll(int fd, const void* data, size_t size)
+    {
+      const char* p = static_cast< const char* >(data);
+      while (size) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+          continue;
+        } else if (n <= 0) {
+          return false;
+        }
+        p += n;
+        size -= static_cast< size_t >(n);
+      }
+      return true;
+    }
+
+    bool recvAll(int fd, void* data, size_t size)
+    {
+      char* p = static_cast< char* >(data);
+      while (size) {
+        ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) {
+          continue;
+        } else if (n <= 0) {
+          return false;
+        }
+        p += n;
+        size -= static_cast< size_t >(n);
+      }
+      return true;
+    }
+
+    void setNoDelay(int fd)
+    {
+      int one = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    bool parseAddress(const char* text, sockaddr_in& addr)
+    {
+      const char* colon = text ? std::strrchr(text, ':') : nullptr;
+      if (!colon || colon[1] == '\0') {
+        return false;
+      }
+      std::string host(text, colon);
+      char* end = nullptr;
+      unsigned long port = std::strtoul(colon + 1, &end, 10);
+      addr = sockaddr_in{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(static_cast< uint16_t >(port));
+      return *end == '\0' && port > 0 && port <= 65535 && ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+    }
+
+    int listenOn(const sockaddr_in& addr, size_t backlog)
+    {
+      int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      int one = 1;
+      const sockaddr* sa = reinterpret_cast< const sockaddr* >(&addr);
+      bool ok = fd >= 0 && ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0;
+      ok = ok && ::bind(fd, sa, sizeof(addr)) == 0;
+      ok = ok && ::listen(fd, static_cast< int >(std::min< size_t >(backlog, SOMAXCONN))) == 0;
+      if (!ok) {
+        closeFd(fd);
+      }
+      return fd;
+    }
+
+    int connectTo(const sockaddr_in& addr)
+    {
+      int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      const sockaddr* sa = reinterpret_cast< const sockaddr* >(&addr);
+      if (fd >= 0 && ::connect(fd, sa, sizeof(addr)) != 0) {
+        closeFd(fd);
+      }
+      if (fd >= 0) {
+        setNoDelay(fd);
+      }
+      return fd;
+    }
+
+    int acceptFrom(int listener)
+    {
+      int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd >= 0) {
+        setNoDelay(fd);
+      }
+      return fd;
+    }
+
+    // A connected pair of stream sockets. TCP goes through a loopback
+    // listener, so the workers see the same sockets a remote peer would give.
+    bool makeLink(ShardTransport transport, int* fds)
+    {
+      fds[0] = -1;
+      fds[1] = -1;
+      if (transport == ShardTransport::UNIX) {
+        return ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0;
+      }
+      int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = 0;
+      socklen_t len = sizeof(addr);
+      sockaddr* sa = reinterpret_cast< sockaddr* >(&addr);
+      bool ok = listener >= 0 && ::bind(listener, sa, sizeof(addr)) == 0 && ::listen(listener, 1) == 0;
+      ok = ok && ::getsockname(listener, sa, &len) == 0;
+      fds[0] = ok ? ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0) : -1;
+      ok = ok && fds[0] >= 0 && ::connect(fds[0], sa, len) == 0;
+      fds[1] = ok ? ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC) : -1;
+      ok = ok && fds[1] >= 0;
+      closeFd(listener);
+      if (!ok) {
+        closeFd(fds[0]);
+        closeFd(fds[1]);
+        return false;
+      }
+      setNoDelay(fds[0]);
+      setNoDelay(fds[1]);
+      return true;
+    }
+
+    // Receives one band, swaps the boundary rows with the neighbours and
+    // replies with the band's local-max count and column-repeat flags.
+    int serveBand(int control, int up, int down)
+    {
+      BandHeader h{0, 0, 0, 0};
+      if (!recvAll(control, &h, sizeof(h))) {
+        return 1;
+      }
+      const size_t cols = h.cols;
+      const size_t band = h.end - h.begin;
+      const size_t maxRows = cols ? std::numeric_limits< size_t >::max() / sizeof(int) / cols : 0;
+      if (h.begin >= h.end || h.end > h.rows || maxRows < 2 || band > maxRows - 2) {
+        return 1;
+      }
+      const size_t hasUp = up >= 0;
+      const size_t hasDown = down >= 0;
+      const size_t rowBytes = cols * sizeof(int);
+      std::vector< int > buf((band + hasUp + hasDown) * cols);
+      int* own = buf.data() + hasUp * cols;
+      if (!recvAll(control, own, band * rowBytes)) {
+        return 1;
+      }
+
+      bool sent = true;
+      std::thread sender([&]() {
+        sent = (!hasUp || sendAll(up, own, rowBytes)) && (!hasDown || sendAll(down, own + (band - 1) * cols, rowBytes));
+      });
+      bool got = (!hasUp || recvAll(up, buf.data(), rowBytes)) && (!hasDown || recvAll(down, own + band * cols, rowBytes));
+      sender.join();
+      if (!sent || !got) {
+        return 1;
+      }
+
+      const size_t localRows = band + hasUp + hasDown;
+      const size_t first = std::max< size_t >(h.begin, 1) - h.begin + hasUp;
+      const size_t last = std::min< size_t >(h.end, h.rows - 1) - h.begin + hasUp;
+      int64_t locMax = first < last ? cntLocMaxRows(buf.data(), localRows, cols, first, last) : 0;
+
+      std::vector< char > repeats(cols, 0);
+      for (size_t i = first; i < hasUp + band; ++i) {
+        const int* upper = buf.data() + (i - 1) * cols;
+        const int* lower = upper + cols;
+        for (size_t j = 0; j < cols; ++j) {
+          repeats[j] |= upper[j] == lower[j];
+        }
+      }
+      bool ok = sendAll(control, &locMax, sizeof(locMax)) && sendAll(control, repeats.data(), cols);
+      return ok ? 0 : 1;
+    }
+
+    int runWorker(int control, int up, int down)
+    {
+      try {
+        return serveBand(control, up, down);
+      } catch (const std::exception&) {
+        return 1;
+      }
+    }
+
+    // Accepts one control connection per band from workers started with
+    // KUZNETSOV_SHARD_WORKER, in connection order, then tells each worker
+    // where its lower neighbour accepts the halo link.
+    bool acceptWorkers(const char* address, size_t workers, std::vector< int >& control)
+    {
+      sockaddr_in addr{};
+      int listener = parseAddress(address, addr) ? listenOn(addr, workers) : -1;
+      bool ok = listener >= 0;
+      std::vector< PeerAddress > peers(workers);
+      for (size_t k = 0; ok && k < workers; ++k) {
+        control[2 * k] = acceptFrom(listener);
+        ok = control[2 * k] >= 0 && recvAll(control[2 * k], &peers[k], sizeof(PeerAddress));
+      }
+      closeFd(listener);
+      for (size_t k = 0; ok && k < workers; ++k) {
+        LinkPlan link{0, 0, k > 0, k + 1 < workers};
+        if (link.hasDown) {
+          link.downAddr = peers[k + 1].addr;
+          link.downPort = peers[k + 1].port;
+        }
+        ok = sendAll(control[2 * k], &link, sizeof(link));
+      }
+      return ok;
+    }
+
+    bool forkWorkers(ShardTransport transport, size_t workers, std::vector< int >& control, std::vector< pid_t >& pids)
+    {
+      std::vector< int > links(2 * (workers - 1), -1);
+      bool ok = true;
+      for (size_t k = 0; ok && k < workers; ++k) {
+        ok = makeLink(transport, control.data() + 2 * k);
+      }
+      for (size_t k = 0; ok && k + 1 < workers; ++k) {
+        ok = makeLink(transport, links.data() + 2 * k);
+      }
+      for (size_t k = 0; ok && k < workers; ++k) {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+          int own = control[2 * k + 1];
+          int up = k > 0 ? links[2 * (k - 1) + 1] : -1;
+          int down = k + 1 < workers ? links[2 * k] : -1;
+          for (int& fd: control) {
+            if (fd != own) {
+              closeFd(fd);
+            }
+          }
+          for (int& fd: links) {
+            if (fd != up && fd != down) {
+              closeFd(fd);
+            }
+          }
+          ::_exit(runWorker(own, up, down));
+        }
+        ok = pid > 0;
+        if (ok) {
+          pids.push_back(pid);
+        }
+      }
+      for (size_t k = 0; k < workers; ++k) {
+        closeFd(control[2 * k + 1]);
+      }
+      for (int& fd: links) {
+        closeFd(fd);
+      }
+      return ok;
+    }
+
+    void killWorkers(const std::vector< pid_t >& pids)
+    {
+      for (pid_t pid: pids) {
+        ::kill(pid, SIGKILL);
+      }
+    }
+
+    bool waitWorkers(const std::vector< pid_t >& pids)
+    {
+      bool ok = true;
+      for (pid_t pid: pids) {
+        int status = 0;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      }
+      return ok;
+    }
+  }
+}
+
+kuznetsov::ShardPlan kuznetsov::getShardPlan(const char* workers, const char* transport, const char* listen)
+{
+  char* end = nullptr;
+  unsigned long count = workers ? std::strtoul(workers, &end, 10) : 0;
+  if (!workers || !*workers || *end != '\0' || count == 0) {
+    count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  bool tcp = transport && std::strcmp(transport, "tcp") == 0;
+  return ShardPlan{count, tcp ? ShardTransport::TCP : ShardTransport::UNIX, listen && *listen ? listen : nullptr};
+}
+
+bool kuznetsov::runSharded(std::istream& input, size_t rows, size_t cols, ShardPlan plan, ShardResult& res)
+{
+  res = ShardResult{0, 0};
+  if (rows == 0 || cols == 0) {
+    return true;
+  }
+  const size_t workers = std::min(std::max< size_t >(plan.workers, 1), rows);
+  std::vector< int > row(cols);
+  std::vector< char > repeats(cols, 0);
+  std::vector< char > part(cols);
+  std::vector< int > control(2 * workers, -1);
+  std::vector< pid_t > pids;
+  bool ok = plan.listen ? acceptWorkers(plan.listen, workers, control) : forkWorkers(plan.transport, workers, control, pids);
+
+  {
+    TraceSpan span("stage", "shard stream");
+    for (size_t k = 0; ok && k < workers; ++k) {
+      BandHeader h{rows * k / workers, rows * (k + 1) / workers, rows, cols};
+      ok = sendAll(control[2 * k], &h, sizeof(h));
+      for (size_t i = h.begin; ok && i < h.end; ++i) {
+        for (size_t j = 0; input && j < cols; ++j) {
+          input >> row[j];
+        }
+        ok = input && sendAll(control[2 * k], row.data(), cols * sizeof(int));
+      }
+    }
+  }
+
+  int64_t locMax = 0;
+  {
+    TraceSpan span("stage", "shard reduce");
+    for (size_t k = 0; ok && k < workers; ++k) {
+      int64_t count = 0;
+      ok = recvAll(control[2 * k], &count, sizeof(count)) && recvAll(control[2 * k], part.data(), cols);
+      locMax += count;
+      for (size_t j = 0; ok && j < cols; ++j) {
+        repeats[j] |= part[j];
+      }
+    }
+  }
+  if (!ok) {
+    killWorkers(pids);
+  }
+  for (size_t k = 0; k < workers; ++k) {
+    closeFd(control[2 * k]);
+  }
+  ok = waitWorkers(pids) && ok;
+  res.cntColNsm = static_cast< int >(std::count(repeats.begin(), repeats.end(), 0));
+  res.cntLocMax = static_cast< int >(locMax);
+  return ok || !input;
+}
+
+bool kuznetsov::runShardWorker(const char* coordinator)
+{
+  sockaddr_in addr{};
+  int control = parseAddress(coordinator, addr) ? connectTo(addr) : -1;
+  sockaddr_in local{};
+  socklen_t len = sizeof(local);
+  sockaddr* sa = reinterpret_cast< sockaddr* >(&local);
+  bool ok = control >= 0 && ::getsockname(control, sa, &len) == 0;
+  local.sin_port = 0;
+  int listener = ok ? listenOn(local, 1) : -1;
+  ok = ok && listener >= 0 && ::getsockname(listener, sa, &len) == 0;
+  PeerAddress self{local.sin_addr.s_addr, local.sin_port, 0};
+  ok = ok && sendAll(control, &self, sizeof(self));
+
+  LinkPlan link{0, 0, 0, 0};
+  ok = ok && recvAll(control, &link, sizeof(link));
+  int up = -1;
+  int down = -1;
+  if (ok && link.hasDown) {
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = link.downAddr;
+    peer.sin_port = link.downPort;
+    down = connectTo(peer);
+    ok = down >= 0;
+  }
+  if (ok && link.hasUp) {
+    up = acceptFrom(listener);
+    ok = up >= 0;
+  }
+  closeFd(listener);
+  ok = ok && runWorker(control, up, down) == 0;
+  closeFd(up);
+  closeFd(down);
+  closeFd(control);
+  return ok;
+}
@@ -0,0 +1,41 @@
+#ifndef KUZNETSOV_SHARD_HPP
+#define KUZNETSOV_SHARD_HPP
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace kuznetsov {
+  enum class ShardTransport {
+    UNIX,
+    TCP
+  };
+
+  // Workers are forked on this host unless listen holds an "ipv4:port"
+  // address; then the coordinator waits there for workers started with
+  // runShardWorker, on this or other hosts, and all links are TCP.
+  struct ShardPlan {
+    size_t workers;
+    ShardTransport transport;
+    const char* listen;
+  };
+
+  struct ShardResult {
+    int cntColNsm;
+    int cntLocMax;
+  };
+
+  ShardPlan getShardPlan(const char* workers, const char* transport, const char* listen);
+
+  // Streams the matrix from input into worker processes, one row band each.
+  // Workers swap halo rows with their neighbours and send back partial
+  // counts. Returns false if a worker or link failed; a failed read is left
+  // in the input state for the caller to report.
+  bool runSharded(std::istream& input, size_t rows, size_t cols, ShardPlan plan, ShardResult& res);
+
+  // Standalone worker: connects to the coordinator at "ipv4:port", opens
+  // a listener for its upper neighbour's halo link on the interface that
+  // reaches the coordinator, then serves one band.
+  bool runShardWorker(const char* coordinator);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+namespace kuznetsov {
+  namespace {
+    const size_t RING_SIZE = 4096;
+
+    struct Event {
+      const char* cat;
+      const char* name;
+      uint64_t begin;
+      uint64_t end;
+    };
+
+    struct Ring {
+      Event events[RING_SIZE];
+      std::atomic< size_t > head;
+      unsigned tid;
+      const char* threadName;
+      Ring* next;
+    };
+
+    const char* tracePath = std::getenv("KUZNETSOV_TRACE");
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic< Ring* > rings{nullptr};
+    std::atomic< unsigned > nextTid{0};
+    thread_local Ring* local = nullptr;
+
+    Ring* localRing()
+    {
+      if (local == nullptr) {
+        Ring* ring = new Ring;
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+        ring->threadName = nullptr;
+        ring->next = rings.load(std::memory_order_relaxed);
+        while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        local = ring;
+      }
+      return local;
+    }
+
+    void writeEvent(std::ostream& out, bool& first, const Ring* ring, const Event& e)
+    {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.cat << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid;
+      out << ",\"ts\":" << e.begin / 1000.0 << ",\"dur\":" << (e.end - e.begin) / 1000.0 << "}";
+    }
+
+    void writeTrace()
+    {
+      std::ofstream out(tracePath);
+      out.setf(std::ios::fixed);
+      out.precision(3);
+      out << "{\"traceEvents\":[";
+      bool first = true;
+      for (const Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        size_t head = ring->head.load(std::memory_order_acquire);
+        size_t tail = head > RING_SIZE ? head - RING_SIZE : 0;
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid;
+        out << ",\"args\":{\"name\":\"" << (ring->threadName ? ring->threadName : "thread") << "\",\"dropped\":" << tail << "}}";
+        for (size_t i = tail; i < head; ++i) {
+          writeEvent(out, first, ring, ring->events[i % RING_SIZE]);
+        }
+      }
+      out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    const bool registered = tracePath && std::atexit(writeTrace) == 0;
+  }
+}
+
+bool kuznetsov::traceEnabled()
+{
+  return registered;
+}
+
+uint64_t kuznetsov::traceNow()
+{
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast< std::chrono::nanoseconds >(elapsed).count();
+}
+
+void kuznetsov::traceRecord(const char* cat, const char* name, uint64_t begin, uint64_t end)
+{
+  if (!registered) {
+    return;
+  }
+  Ring* ring = localRing();
+  size_t head = ring->head.load(std::memory_order_relaxed);
+  ring->events[head % RING_SIZE] = Event{cat, name, begin, end};
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void kuznetsov::traceThreadName(const char* name)
+{
+  if (registered) {
+    localRing()->threadName = name;
+  }
+}
+
+kuznetsov::TraceSpan::TraceSpan(const char* cat, const char* name):
+  cat_(cat),
+  name_(name),
+  begin_(registered ? traceNow() : 0)
+{}
+
+kuznetsov::TraceSpan::~TraceSpan()
+{
+  if (registered) {
+    traceRecord(cat_, name_, begin_, traceNow());
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef KUZNETSOV_TRACE_HPP
+#define KUZNETSOV_TRACE_HPP
+
+#include <cstdint>
+
+namespace kuznetsov {
+  // Spans are kept in per-thread rings and dumped as a Chrome trace
+  // to the file named by KUZNETSOV_TRACE when the program exits.
+  bool traceEnabled();
+  uint64_t traceNow();
+  void traceRecord(const char* cat, const char* name, uint64_t begin, uint64_t end);
+  void traceThreadName(const char* name);
+
+  class TraceSpan {
+  public:
+    TraceSpan(const char* cat, const char* name);
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* cat_;
+    const char* name_;
+    uint64_t begin_;
+  };
+}
+
+#endif
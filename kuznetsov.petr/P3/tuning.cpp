@@ -0,0 +1,154 @@
+#include "tuning.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "matrix.hpp"
+#include "parallel.hpp"
+
+namespace kuznetsov {
+  namespace {
+    const size_t SWEEP_REPEATS = 3;
+
+    template< class F >
+    double bestTime(F f)
+    {
+      double best = 0.0;
+      for (size_t r = 0; r < SWEEP_REPEATS; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        volatile int sink = f();
+        static_cast< void >(sink);
+        std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+        if (r == 0 || elapsed.count() < best) {
+          best = elapsed.count();
+        }
+      }
+      return best;
+    }
+  }
+}
+
+std::string kuznetsov::getCpuModel()
+{
+  std::ifstream info("/proc/cpuinfo");
+  std::string line;
+  std::string model = "unknown";
+  while (std::getline(info, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      size_t colon = line.find(':');
+      model = colon == std::string::npos ? line : line.substr(line.find_first_not_of(' ', colon + 1));
+      break;
+    }
+  }
+  return model + " x" + std::to_string(std::thread::hardware_concurrency());
+}
+
+bool kuznetsov::loadTuning(const char* path, TuningProfile& prof)
+{
+  std::ifstream input(path);
+  TuningProfile res{"", 1, 0, 0};
+  std::string key;
+  while (input >> key) {
+    if (key == "cpu") {
+      input >> std::ws;
+      std::getline(input, res.cpu);
+    } else if (key == "threads") {
+      input >> res.threads;
+    } else if (key == "band") {
+      input >> res.bandRows;
+    } else if (key == "coltile") {
+      input >> res.colTile;
+    } else {
+      return false;
+    }
+  }
+  if (!input.eof() || res.cpu.empty()) {
+    return false;
+  }
+  prof = res;
+  return true;
+}
+
+bool kuznetsov::saveTuning(const char* path, const TuningProfile& prof)
+{
+  std::ofstream output(path);
+  output << "cpu " << prof.cpu << '\n';
+  output << "threads " << prof.threads << '\n';
+  output << "band " << prof.bandRows << '\n';
+  output << "coltile " << prof.colTile << '\n';
+  return static_cast< bool >(output);
+}
+
+const kuznetsov::TuningProfile& kuznetsov::getTuning()
+{
+  static const TuningProfile prof = []() {
+    TuningProfile res{"", 1, 0, 0};
+    const char* path = std::getenv("KUZNETSOV_TUNING");
+    if (!path) {
+      return res;
+    }
+    TuningProfile loaded{"", 1, 0, 0};
+    if (!loadTuning(path, loaded)) {
+      std::cerr << "Bad tuning profile, using defaults\n";
+    } else if (loaded.cpu != getCpuModel()) {
+      std::cerr << "Stale tuning profile (CPU changed), using defaults\n";
+    } else {
+      res = loaded;
+    }
+    return res;
+  }();
+  return prof;
+}
+
+kuznetsov::TuningProfile kuznetsov::autotune(size_t rows, size_t cols)
+{
+  std::vector< int > mtx(rows * cols);
+  std::minstd_rand gen(rows * 31 + cols);
+  std::uniform_int_distribution< int > dist(0, 255);
+  for (int& v: mtx) {
+    v = dist(gen);
+  }
+
+  TuningProfile prof{getCpuModel(), 1, 0, 0};
+  size_t hw = std::max(1u, std::thread::hardware_concurrency());
+  double best = bestTime([&]() {
+    return getCntLocMax(mtx.data(), rows, cols);
+  });
+  std::vector< size_t > threadCounts;
+  for (size_t threads = 2; threads < hw; threads *= 2) {
+    threadCounts.push_back(threads);
+  }
+  if (hw > 1) {
+    threadCounts.push_back(hw);
+  }
+  for (size_t threads: threadCounts) {
+    for (size_t band = 1; band <= rows; band *= 4) {
+      double t = bestTime([&]() {
+        return getCntLocMaxBands(mtx.data(), rows, cols, BandConfig{threads, band});
+      });
+      if (t < best) {
+        best = t;
+        prof.threads = threads;
+        prof.bandRows = band;
+      }
+    }
+  }
+
+  best = bestTime([&]() {
+    return getCntColNsm(mtx.data(), rows, cols);
+  });
+  for (size_t tile = 8; tile <= std::min< size_t >(cols, 4096); tile *= 2) {
+    double t = bestTime([&]() {
+      return getCntColNsmTiled(mtx.data(), rows, cols, tile);
+    });
+    if (t < best) {
+      best = t;
+      prof.colTile = tile;
+    }
+  }
+  return prof;
+}
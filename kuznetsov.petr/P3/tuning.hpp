@@ -0,0 +1,22 @@
+#ifndef KUZNETSOV_TUNING_HPP
+#define KUZNETSOV_TUNING_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace kuznetsov {
+  struct TuningProfile {
+    std::string cpu;
+    size_t threads;
+    size_t bandRows;
+    size_t colTile;
+  };
+
+  std::string getCpuModel();
+  bool loadTuning(const char* path, TuningProfile& prof);
+  bool saveTuning(const char* path, const TuningProfile& prof);
+  const TuningProfile& getTuning();
+  TuningProfile autotune(size_t rows, size_t cols);
+}
+
+#endif
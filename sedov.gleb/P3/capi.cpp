@@ -0,0 +1,78 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+
+namespace sedov
+{
+  namespace
+  {
+    bool isMatrix(const int * mtx, size_t stride, size_t rows, size_t cols)
+    {
+      return rows == 0 || cols == 0 || (mtx != nullptr && stride >= cols);
+    }
+
+    void copyRows(const int * src, size_t srcStride, size_t rows, size_t cols, int * dst, size_t dstStride)
+    {
+      for (size_t i = 0; i < rows; ++i)
+      {
+        std::copy(src + i * srcStride, src + i * srcStride + cols, dst + i * dstStride);
+      }
+    }
+  }
+}
+
+unsigned sedov_capiVersion(void)
+{
+  return SEDOV_CAPI_VERSION;
+}
+
+int sedov_convertIncMatrix(int * mtx, size_t stride, size_t rows, size_t cols)
+{
+  if (!sedov::isMatrix(mtx, stride, rows, cols))
+  {
+    return SEDOV_EINVAL;
+  }
+  try
+  {
+    std::vector< int > dense(rows * cols);
+    sedov::copyRows(mtx, stride, rows, cols, dense.data(), cols);
+    sedov::convertIncMatrix(dense.data(), rows, cols);
+    sedov::copyRows(dense.data(), cols, rows, cols, mtx, stride);
+  }
+  catch (const std::overflow_error &)
+  {
+    return SEDOV_EOVERFLOW;
+  }
+  catch (const std::bad_alloc &)
+  {
+    return SEDOV_ENOMEM;
+  }
+  return SEDOV_OK;
+}
+
+int sedov_getNumCol(const int * mtx, size_t stride, size_t rows, size_t cols, size_t * result)
+{
+  if (!sedov::isMatrix(mtx, stride, rows, cols) || result == nullptr)
+  {
+    return SEDOV_EINVAL;
+  }
+  if (stride == cols || rows < 2)
+  {
+    *result = sedov::getNumCol(mtx, rows, cols);
+    return SEDOV_OK;
+  }
+  try
+  {
+    std::vector< int > dense(rows * cols);
+    sedov::copyRows(mtx, stride, rows, cols, dense.data(), cols);
+    *result = sedov::getNumCol(dense.data(), rows, cols);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return SEDOV_ENOMEM;
+  }
+  return SEDOV_OK;
+}
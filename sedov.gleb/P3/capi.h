@@ -0,0 +1,35 @@
+#ifndef SEDOV_CAPI_H
+#define SEDOV_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SEDOV_CAPI_VERSION 1
+
+#define SEDOV_OK 0
+#define SEDOV_EINVAL 1
+#define SEDOV_EOVERFLOW 2
+#define SEDOV_ENOMEM 3
+
+/*
+ * Matrices belong to the caller: rows x cols, row-major, rows placed
+ * stride elements apart with stride >= cols.
+ */
+
+unsigned sedov_capiVersion(void);
+
+/* Increment matrix conversion in place; nothing is written on overflow */
+int sedov_convertIncMatrix(int * mtx, size_t stride, size_t rows, size_t cols);
+
+/* 1-based column with the longest run of equal neighbours, 0 if none */
+int sedov_getNumCol(const int * mtx, size_t stride, size_t rows, size_t cols, size_t * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
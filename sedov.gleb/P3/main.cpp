@@ -1,14 +1,20 @@
 #include <iostream>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <limits>
 #include <fstream>
+#include <stdexcept>
+#include "matrix.hpp"
+#include "npy.hpp"
+#include "stream.hpp"
 
 namespace sedov
 {
   std::istream & inputMatrix(std::istream & input, int * mtx, size_t rows, size_t cols);
-  void convertIncMatrix(int * mtx, size_t rows, size_t cols);
-  size_t getNumCol(const int * mtx, size_t rows, size_t cols);
   size_t completeMatrix(std::istream & input, int * mtx, size_t rows, size_t cols, const char * out);
+  size_t writeIncMatrix(int * mtx, size_t rows, size_t cols, const char * out);
+  size_t completeMatrixStream(std::istream & input, size_t rows, size_t cols, const char * out);
 }
 
 int main(int argc, char ** argv)
@@ -29,6 +35,26 @@ int main(int argc, char ** argv)
     return 1;
   }
 
+  if (sedov::isNpyPath(argv[2]))
+  {
+    sedov::NpyMatrix matrix;
+    try
+    {
+      matrix.open(argv[2]);
+    }
+    catch (const std::bad_alloc & e)
+    {
+      std::cerr << e.what() << "\n";
+      return 3;
+    }
+    catch (const std::runtime_error & e)
+    {
+      std::cerr << e.what() << "\n";
+      return 2;
+    }
+    return sedov::writeIncMatrix(matrix.data(), matrix.rows(), matrix.cols(), argv[3]);
+  }
+
   size_t r = 0, c = 0;
   std::ifstream input(argv[2]);
   input >> r >> c;
@@ -38,6 +64,11 @@ int main(int argc, char ** argv)
     return 2;
   }
 
+  if (std::getenv("SEDOV_STREAM") && !sedov::isNpyPath(argv[3]))
+  {
+    return sedov::completeMatrixStream(input, r, c, argv[3]);
+  }
+
   if (argv[1][0] == '1')
   {
     int matrix[10000];
@@ -68,53 +99,6 @@ std::istream & sedov::inputMatrix(std::istream & input, int * mtx, size_t rows,
   return input;
 }
 
-void sedov::convertIncMatrix(int * mtx, size_t rows, size_t cols)
-{
-  size_t minrc = std::min(rows, cols);
-  size_t layer = minrc / 2 + minrc % 2;
-  const int MAX = std::numeric_limits< int >::max();
-  for (size_t k = 0; k < layer; ++k)
-  {
-    for (size_t i = k; i < rows - k; ++i)
-    {
-      for (size_t j = k; j < cols - j; ++j)
-      {
-        if (mtx[i * cols + j] > MAX - 1)
-        {
-          throw std::overflow_error("Increment matrix overflow");
-        }
-        mtx[i * cols + j] += 1;
-      }
-    }
-  }
-}
-
-size_t sedov::getNumCol(const int * mtx, size_t rows, size_t cols)
-{
-  size_t maxLength = 0, maxCol = 0;
-  for (size_t j = 0; j < cols; ++j)
-  {
-    size_t length = 0;
-    for (size_t i = 1; i < rows; ++i)
-    {
-      if (mtx[i * cols + j] == mtx[(i - 1) * cols + j])
-      {
-        length += 1;
-        if (length > maxLength)
-        {
-          maxLength = length;
-          maxCol = j + 1;
-        }
-      }
-      else
-      {
-        length = 0;
-      }
-    }
-  }
-  return maxCol;
-}
-
 size_t sedov::completeMatrix(std::istream & input, int * mtx, size_t rows, size_t cols, const char * out)
 {
   inputMatrix(input, mtx, rows, cols);
@@ -130,10 +114,22 @@ size_t sedov::completeMatrix(std::istream & input, int * mtx, size_t rows, size_
     }
     return 2;
   }
+  return writeIncMatrix(mtx, rows, cols, out);
+}
+
+size_t sedov::writeIncMatrix(int * mtx, size_t rows, size_t cols, const char * out)
+{
   size_t res1 = getNumCol(mtx, rows, cols);
   try
   {
     convertIncMatrix(mtx, rows, cols);
+    if (isNpyPath(out))
+    {
+      std::ofstream output(out, std::ios::binary);
+      writeNpy(output, mtx, rows, cols);
+      std::cout << res1 << "\n";
+      return 0;
+    }
     std::ofstream output(out);
     output << mtx << "\n";
     output << res1 << "\n";
@@ -145,3 +141,35 @@ size_t sedov::completeMatrix(std::istream & input, int * mtx, size_t rows, size_
     return 3;
   }
 }
+
+size_t sedov::completeMatrixStream(std::istream & input, size_t rows, size_t cols, const char * out)
+{
+  std::ofstream output(out);
+  try
+  {
+    size_t res1 = streamIncMatrix(input, output, rows, cols);
+    if (input)
+    {
+      output << res1 << "\n";
+      return 0;
+    }
+  }
+  catch (const std::overflow_error & e)
+  {
+    output.close();
+    std::remove(out);
+    std::cerr << e.what() << "\n";
+    return 3;
+  }
+  output.close();
+  std::remove(out);
+  if (input.eof())
+  {
+    std::cerr << "Not enough arguments for matrix\n";
+  }
+  else
+  {
+    std::cerr << "Bad reading\n";
+  }
+  return 2;
+}
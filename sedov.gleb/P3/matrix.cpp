@@ -0,0 +1,63 @@
+#include "matrix.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+size_t sedov::addRowChecked(int * row, size_t begin, size_t end, int add)
+{
+  const unsigned uadd = static_cast< unsigned >(add);
+  size_t first = end;
+  for (size_t j = begin; j < end; ++j)
+  {
+    unsigned value = static_cast< unsigned >(row[j]);
+    unsigned sum = value + uadd;
+    bool overflow = ((value ^ sum) & (uadd ^ sum)) >> 31;
+    row[j] = static_cast< int >(sum);
+    first = std::min(first, overflow ? j : end);
+  }
+  return first;
+}
+
+void sedov::convertIncMatrix(int * mtx, size_t rows, size_t cols)
+{
+  size_t minrc = std::min(rows, cols);
+  size_t layer = minrc / 2 + minrc % 2;
+  size_t half = cols / 2 + cols % 2;
+  for (size_t k = 0; k < layer; ++k)
+  {
+    for (size_t i = k; i < rows - k; ++i)
+    {
+      size_t j = addRowChecked(mtx + i * cols, k, half, 1);
+      if (j != half)
+      {
+        throw std::overflow_error("Increment matrix overflow at " + std::to_string(i) + " " + std::to_string(j));
+      }
+    }
+  }
+}
+
+size_t sedov::getNumCol(const int * mtx, size_t rows, size_t cols)
+{
+  size_t maxLength = 0, maxCol = 0;
+  for (size_t j = 0; j < cols; ++j)
+  {
+    size_t length = 0;
+    for (size_t i = 1; i < rows; ++i)
+    {
+      if (mtx[i * cols + j] == mtx[(i - 1) * cols + j])
+      {
+        length += 1;
+        if (length > maxLength)
+        {
+          maxLength = length;
+          maxCol = j + 1;
+        }
+      }
+      else
+      {
+        length = 0;
+      }
+    }
+  }
+  return maxCol;
+}
@@ -0,0 +1,13 @@
+#ifndef SEDOV_MATRIX_HPP
+#define SEDOV_MATRIX_HPP
+
+#include <cstddef>
+
+namespace sedov
+{
+  size_t addRowChecked(int * row, size_t begin, size_t end, int add);
+  void convertIncMatrix(int * mtx, size_t rows, size_t cols);
+  size_t getNumCol(const int * mtx, size_t rows, size_t cols);
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "stream.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+size_t sedov::getLayerInc(size_t i, size_t j, size_t rows, size_t cols)
+{
+  size_t minrc = std::min(rows, cols);
+  size_t layer = minrc / 2 + minrc % 2;
+  size_t half = cols / 2 + cols % 2;
+  if (layer == 0 || j >= half)
+  {
+    return 0;
+  }
+  return std::min(std::min(layer - 1, i), std::min(j, rows - 1 - i)) + 1;
+}
+
+size_t sedov::streamIncMatrix(std::istream & input, std::ostream & output, size_t rows, size_t cols)
+{
+  // convertIncMatrix adds one layer at a time and throws at the first cell
+  // that overflows, so the cell to report is the one with the smallest
+  // (layer, row, column) among all overflowing cells, not the first row
+  // read; it is only known once the whole matrix has been seen
+  const long long maxInt = std::numeric_limits< int >::max();
+  const size_t none = std::numeric_limits< size_t >::max();
+  size_t badLayer = none, badRow = 0, badCol = 0;
+
+  std::vector< int > row(cols), prev(cols);
+  std::vector< size_t > length(cols, 0), best(cols, 0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      input >> row[j];
+    }
+    if (!input)
+    {
+      return 0;
+    }
+    for (size_t j = 0; j < cols && i > 0; ++j)
+    {
+      length[j] = row[j] == prev[j] ? length[j] + 1 : 0;
+      best[j] = std::max(best[j], length[j]);
+    }
+    prev = row;
+
+    for (size_t j = 0; j < cols; ++j)
+    {
+      size_t inc = getLayerInc(i, j, rows, cols);
+      size_t layer = static_cast< size_t >(maxInt - row[j]);
+      if (layer < inc && layer < badLayer)
+      {
+        badLayer = layer;
+        badRow = i;
+        badCol = j;
+      }
+      row[j] = static_cast< int >(static_cast< unsigned >(row[j]) + static_cast< unsigned >(inc));
+      output << (j ? " " : "") << row[j];
+    }
+    output << "\n";
+  }
+
+  if (badLayer != none)
+  {
+    throw std::overflow_error("Increment matrix overflow at " + std::to_string(badRow) + " " + std::to_string(badCol));
+  }
+  size_t maxLength = cols ? *std::max_element(best.begin(), best.end()) : 0;
+  size_t maxCol = static_cast< size_t >(std::find(best.begin(), best.end(), maxLength) - best.begin());
+  return maxLength ? maxCol + 1 : 0;
+}
@@ -0,0 +1,14 @@
+#ifndef SEDOV_STREAM_HPP
+#define SEDOV_STREAM_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+namespace sedov
+{
+  size_t getLayerInc(size_t i, size_t j, size_t rows, size_t cols);
+  size_t streamIncMatrix(std::istream & input, std::ostream & output, size_t rows, size_t cols);
+}
+
+#endif
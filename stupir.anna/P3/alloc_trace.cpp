@@ -0,0 +1,290 @@
+#include "alloc_trace.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__) && defined(__GNUC__)
+extern "C" const char __executable_start;
+#endif
+
+namespace stupir
+{
+  namespace
+  {
+    const unsigned maxPhases = 16;
+    const unsigned maxSites = 64;
+    const size_t headerSize = alignof(std::max_align_t) > 16 ? alignof(std::max_align_t) : 16;
+
+    struct PhaseStat
+    {
+      const char * name;
+      size_t allocs;
+      size_t frees;
+      size_t bytes;
+      size_t peakLive;
+    };
+
+    struct SiteStat
+    {
+      unsigned phase;
+      const void * site;
+      size_t allocs;
+      size_t bytes;
+    };
+
+    struct Header
+    {
+      size_t size;
+      unsigned phase;
+    };
+
+    PhaseStat phases[maxPhases] = {{"startup", 0, 0, 0, 0}};
+    SiteStat sites[maxSites] = {};
+    unsigned phaseCount = 1;
+    unsigned currentPhase = 0;
+    size_t live = 0;
+    size_t peakLive = 0;
+    size_t lostSites = 0;
+    bool reporting = false;
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+    struct Guard
+    {
+      Guard()
+      {
+        while (lock.test_and_set(std::memory_order_acquire))
+        {}
+      }
+      ~Guard()
+      {
+        lock.clear(std::memory_order_release);
+      }
+    };
+
+    unsigned findPhase(const char * name)
+    {
+      for (unsigned i = 0; i < phaseCount; ++i)
+      {
+        if (std::strcmp(phases[i].name, name) == 0)
+        {
+          return i;
+        }
+      }
+      if (phaseCount == maxPhases)
+      {
+        return 0;
+      }
+      phases[phaseCount] = {name, 0, 0, 0, live};
+      return phaseCount++;
+    }
+
+    void countSite(unsigned phase, const void * site, size_t size)
+    {
+      size_t start = (reinterpret_cast< uintptr_t >(site) >> 2) % maxSites;
+      for (size_t k = 0; k < maxSites; ++k)
+      {
+        SiteStat & s = sites[(start + k) % maxSites];
+        if (s.site == nullptr)
+        {
+          s = {phase, site, 0, 0};
+        }
+        if (s.site == site && s.phase == phase)
+        {
+          s.allocs++;
+          s.bytes += size;
+          return;
+        }
+      }
+      lostSites++;
+    }
+
+    // Decided by the first allocation and never changed afterwards, so a
+    // block is freed the same way it was allocated. Without the variable
+    // new and delete go straight to malloc and free.
+    bool isTracing()
+    {
+      static const bool tracing = std::getenv("STUPIR_ALLOC_TRACE") != nullptr;
+      return tracing;
+    }
+
+    void * rawAllocate(size_t size)
+    {
+      while (true)
+      {
+        void * raw = std::malloc(size ? size : 1);
+        if (raw != nullptr)
+        {
+          return raw;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+          throw std::bad_alloc();
+        }
+        handler();
+      }
+    }
+
+    void * allocate(size_t size, const void * site)
+    {
+      if (!isTracing())
+      {
+        return rawAllocate(size);
+      }
+      if (size > SIZE_MAX - headerSize)
+      {
+        throw std::bad_alloc();
+      }
+      char * raw = static_cast< char * >(rawAllocate(size + headerSize));
+      Header * h = reinterpret_cast< Header * >(raw);
+      h->size = size;
+      Guard g;
+      h->phase = currentPhase;
+      if (!reporting)
+      {
+        PhaseStat & p = phases[currentPhase];
+        p.allocs++;
+        p.bytes += size;
+        live += size;
+        if (live > peakLive)
+        {
+          peakLive = live;
+        }
+        if (live > p.peakLive)
+        {
+          p.peakLive = live;
+        }
+        countSite(currentPhase, site, size);
+      }
+      return raw + headerSize;
+    }
+
+    void deallocate(void * ptr)
+    {
+      if (ptr == nullptr)
+      {
+        return;
+      }
+      if (!isTracing())
+      {
+        std::free(ptr);
+        return;
+      }
+      char * raw = static_cast< char * >(ptr) - headerSize;
+      const Header * h = reinterpret_cast< const Header * >(raw);
+      {
+        Guard g;
+        if (!reporting)
+        {
+          phases[h->phase].frees++;
+          live -= h->size;
+        }
+      }
+      std::free(raw);
+    }
+
+    const void * siteOffset(const void * site)
+    {
+#if defined(__linux__) && defined(__GNUC__)
+      uintptr_t base = reinterpret_cast< uintptr_t >(&__executable_start);
+      uintptr_t addr = reinterpret_cast< uintptr_t >(site);
+      return reinterpret_cast< const void * >(addr >= base ? addr - base : addr);
+#else
+      return site;
+#endif
+    }
+
+    void report()
+    {
+      const char * target = std::getenv("STUPIR_ALLOC_TRACE");
+      if (target == nullptr)
+      {
+        return;
+      }
+      {
+        Guard g;
+        reporting = true;
+      }
+      bool toStderr = target[0] == '\0' || std::strcmp(target, "-") == 0;
+      std::FILE * out = toStderr ? stderr : std::fopen(target, "w");
+      if (out == nullptr)
+      {
+        return;
+      }
+      std::fprintf(out, "phase allocs frees bytes peak_live\n");
+      for (unsigned i = 0; i < phaseCount; ++i)
+      {
+        const PhaseStat & p = phases[i];
+        std::fprintf(out, "%s %zu %zu %zu %zu\n", p.name, p.allocs, p.frees, p.bytes, p.peakLive);
+      }
+      std::fprintf(out, "total_peak_live %zu\nleaked_bytes %zu\n", peakLive, live);
+      std::fprintf(out, "phase site allocs bytes\n");
+      for (unsigned i = 0; i < maxSites; ++i)
+      {
+        const SiteStat & s = sites[i];
+        if (s.site != nullptr)
+        {
+          std::fprintf(out, "%s %p %zu %zu\n", phases[s.phase].name, siteOffset(s.site), s.allocs, s.bytes);
+        }
+      }
+      if (lostSites != 0)
+      {
+        std::fprintf(out, "untracked_sites %zu\n", lostSites);
+      }
+      if (!toStderr)
+      {
+        std::fclose(out);
+      }
+    }
+
+    const bool registered = isTracing() && std::atexit(report) == 0;
+  }
+}
+
+stupir::AllocPhase::AllocPhase(const char * name):
+  prev_(0)
+{
+  Guard g;
+  prev_ = currentPhase;
+  currentPhase = findPhase(name);
+}
+
+stupir::AllocPhase::~AllocPhase()
+{
+  Guard g;
+  currentPhase = prev_;
+}
+
+void * operator new(size_t size)
+{
+  return stupir::allocate(size, __builtin_return_address(0));
+}
+
+void * operator new[](size_t size)
+{
+  return stupir::allocate(size, __builtin_return_address(0));
+}
+
+void operator delete(void * ptr) noexcept
+{
+  stupir::deallocate(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+  stupir::deallocate(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  stupir::deallocate(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+  stupir::deallocate(ptr);
+}
@@ -0,0 +1,23 @@
+#ifndef STUPIR_ALLOC_TRACE_HPP
+#define STUPIR_ALLOC_TRACE_HPP
+
+namespace stupir
+{
+  // Allocations made while a phase object is alive are attributed to it.
+  // The report is printed at exit when STUPIR_ALLOC_TRACE is set
+  // (to a file name, or to "-" for stderr); without it new and delete are
+  // plain malloc and free.
+  class AllocPhase
+  {
+  public:
+    explicit AllocPhase(const char * name);
+    ~AllocPhase();
+    AllocPhase(const AllocPhase &) = delete;
+    AllocPhase & operator=(const AllocPhase &) = delete;
+
+  private:
+    unsigned prev_;
+  };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+
+namespace stupir
+{
+  namespace
+  {
+    bool checkArgs(const int * arr, size_t stride, size_t rows, size_t cols)
+    {
+      return rows == 0 || cols == 0 || (arr && stride >= cols);
+    }
+
+    void copyRows(const int * from, size_t fromStride, size_t rows, size_t cols, int * to, size_t toStride)
+    {
+      for (size_t i = 0; i < rows; ++i)
+      {
+        std::copy(from + i * fromStride, from + i * fromStride + cols, to + i * toStride);
+      }
+    }
+
+    const int * packRows(const int * arr, size_t stride, size_t rows, size_t cols, std::vector< int > & buf)
+    {
+      if (stride == cols)
+      {
+        return arr;
+      }
+      buf.resize(rows * cols);
+      copyRows(arr, stride, rows, cols, buf.data(), cols);
+      return buf.data();
+    }
+  }
+}
+
+unsigned stupir_capiVersion(void)
+{
+  return STUPIR_CAPI_VERSION;
+}
+
+int stupir_addSnail(const int * src, size_t srcStride, size_t rows, size_t cols, int * dst, size_t dstStride)
+{
+  if (!stupir::checkArgs(src, srcStride, rows, cols) || !stupir::checkArgs(dst, dstStride, rows, cols))
+  {
+    return STUPIR_EINVAL;
+  }
+  if (rows == 0 || cols == 0)
+  {
+    return STUPIR_OK;
+  }
+  try
+  {
+    std::vector< int > srcBuf;
+    std::vector< int > dstBuf;
+    const int * arr1 = stupir::packRows(src, srcStride, rows, cols, srcBuf);
+    int * arr2 = dst;
+    if (dstStride != cols)
+    {
+      dstBuf.resize(rows * cols);
+      stupir::copyRows(dst, dstStride, rows, cols, dstBuf.data(), cols);
+      arr2 = dstBuf.data();
+    }
+    stupir::addSnail(arr1, rows, cols, arr2);
+    if (arr2 != dst)
+    {
+      stupir::copyRows(arr2, cols, rows, cols, dst, dstStride);
+    }
+  }
+  catch (const std::overflow_error &)
+  {
+    return STUPIR_EOVERFLOW;
+  }
+  catch (const std::bad_alloc &)
+  {
+    return STUPIR_ENOMEM;
+  }
+  return STUPIR_OK;
+}
+
+int stupir_countNotZeroD(const int * src, size_t stride, size_t rows, size_t cols, size_t * result)
+{
+  if (!stupir::checkArgs(src, stride, rows, cols) || !result)
+  {
+    return STUPIR_EINVAL;
+  }
+  try
+  {
+    std::vector< int > buf;
+    *result = stupir::countNotZeroD(stupir::packRows(src, stride, rows, cols, buf), rows, cols);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return STUPIR_ENOMEM;
+  }
+  return STUPIR_OK;
+}
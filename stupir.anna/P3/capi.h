@@ -0,0 +1,35 @@
+#ifndef STUPIR_CAPI_H
+#define STUPIR_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define STUPIR_CAPI_VERSION 1
+
+/* Status codes returned by the kernels */
+#define STUPIR_OK 0
+#define STUPIR_EINVAL 1
+#define STUPIR_EOVERFLOW 2
+#define STUPIR_ENOMEM 3
+
+/*
+ * Matrices are row-major and owned by the caller; stride is the distance
+ * between the starts of two rows in elements and must not be less than cols.
+ */
+
+unsigned stupir_capiVersion(void);
+
+/* Adds the snail numbering of src to dst; dst is unspecified on overflow */
+int stupir_addSnail(const int * src, size_t srcStride, size_t rows, size_t cols, int * dst, size_t dstStride);
+
+int stupir_countNotZeroD(const int * src, size_t stride, size_t rows, size_t cols, size_t * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,71 +1,16 @@
 #include <iostream>
 #include <fstream>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include "alloc_trace.hpp"
+#include "matrix.hpp"
+#include "npy.hpp"
+#include "write_behind.hpp"
 
 namespace stupir
 {
-  bool checkAddSnail(size_t up, size_t down, size_t left, size_t right)
-  {
-    return (up <= down && left <= right);
-  }
-
-  void addSnail(const int * arr1, size_t rows, size_t cols, int * arr2)
-  {
-    size_t sum = 1;
-    size_t left = 0;
-    size_t right = cols - 1;
-    size_t up = 0;
-    size_t down = rows - 1;
-    while (checkAddSnail(up, down, left, right))
-    {
-      for (size_t i = left; i < right + 1; ++i)
-      {
-        arr2[cols * down + i] += sum + arr1[cols * down + i];
-        sum++;
-      }
-      down--;
-
-      if (!checkAddSnail(up, down, left, right))
-      {
-        break;
-      }
-
-      for (size_t i = down; i > up ; --i)
-      {
-        arr2[cols * i + right] += sum + arr1[cols * i + right];
-        sum++;
-      }
-      arr2[cols * up + right] += sum + arr1[cols * up + right];
-      sum++;
-      right--;
-
-      if (!checkAddSnail(up, down, left, right))
-      {
-        break;
-      }
-
-      for (size_t i = right; i > left; --i)
-      {
-        arr2[up * cols + i] += sum + arr1[up * cols + i];
-        sum++;
-      }
-      arr2[up * cols + left] += sum + arr1[up * cols + left];
-      sum++;
-      up++;
-
-      if (!checkAddSnail(up, down, left, right))
-      {
-        break;
-      }
-
-      for (size_t i = up; i < down + 1; ++i)
-      {
-        arr2[cols * i + left] += sum + arr1[cols * i + left];
-        sum++;
-      }
-      left++;
-    }
-  }
-
   std::ifstream & readArr(std::ifstream & input, size_t rows, size_t cols, int * arr)
   {
     for (size_t i = 0; i < rows * cols; ++i)
@@ -75,7 +20,7 @@ namespace stupir
     return input;
   }
 
-  void writeArr(std::ofstream & output, size_t rows, size_t cols, const int * arr)
+  void writeArr(std::ostream & output, size_t rows, size_t cols, const int * arr)
   {
     if (!output.fail())
     {
@@ -90,53 +35,6 @@ namespace stupir
       std::cerr << "Сouldn't open the file for writing\n";
     }
   }
-
-  size_t countNotZeroD(const int * arr, size_t rows, size_t cols)
-  {
-    size_t result = 0;
-    if (rows == 0 && cols == 0)
-    {
-      return 0;
-    }
-    for (size_t k = 0; k < rows; ++k)
-    {
-      size_t num = 0;
-      for (size_t i = 0; i < rows; ++i)
-      {
-        if (i - k < cols)
-        {
-          if (arr[cols * i + i - k] == 0)
-          {
-            num++;
-          }
-        }
-      }
-      if (num == 0)
-      {
-        result++;
-      }
-    }
-
-    for (size_t k = 1; k < cols; ++k)
-    {
-      size_t num = 0;
-      for (size_t i = 0; i < rows; ++i)
-      {
-        if (i + k < cols)
-        {
-          if (arr[cols * i + i + k] == 0)
-          {
-            num++;
-          }
-        }
-      }
-      if (num == 0)
-      {
-        result++;
-      }
-    }
-    return result;
-  }
 }
 int main(int argc, char ** argv)
 {
@@ -160,86 +58,166 @@ int main(int argc, char ** argv)
     return 1;
   }
 
-  std::ifstream input(secondArg);
-  if (!input.is_open())
-  {
-    std::cerr << "Error when opening a file\n";
-    return 2;
-  }
-
+  stupir::AllocPhase parsePhase("parse");
+  const bool npyInput = stupir::isNpyPath(secondArg);
+  stupir::NpyMatrix npy;
+  std::ifstream input;
   size_t rows = 0;
   size_t cols = 0;
-  input >> rows;
-  input >> cols;
-  if (input.fail() || (rows == 0 && cols) || (rows && cols == 0))
+  if (npyInput)
   {
-    std::cerr << "Irregular matrix sizes\n";
-    return 2;
+    try
+    {
+      npy.open(secondArg);
+    }
+    catch (const std::runtime_error & e)
+    {
+      std::cerr << e.what() << "\n";
+      return 2;
+    }
+    catch (const std::bad_alloc & e)
+    {
+      std::cerr << "Not enough memory\n";
+      return 2;
+    }
+    rows = npy.rows();
+    cols = npy.cols();
+  }
+  else
+  {
+    input.open(secondArg);
+    if (!input.is_open())
+    {
+      std::cerr << "Error when opening a file\n";
+      return 2;
+    }
+
+    input >> rows;
+    input >> cols;
+    if (input.fail() || (rows == 0 && cols) || (rows && cols == 0))
+    {
+      std::cerr << "Irregular matrix sizes\n";
+      return 2;
+    }
   }
 
   const size_t maxStat = 10000;
+  int buffer[maxStat] = {};
   int * matrixFile = nullptr;
   int * matrixChange = nullptr;
+  const int * source = npy.data();
   size_t numDigNotNull = 0;
   namespace stu = stupir;
   try
   {
-    if (firstArg[0] == '1')
+    if (!npyInput)
     {
-      if (rows * cols <= maxStat)
+      if (firstArg[0] == '1')
       {
-        int buffer[maxStat] = {};
-        matrixFile = buffer;
+        if (rows * cols <= maxStat)
+        {
+          matrixFile = buffer;
+        }
+        else
+        {
+          throw std::bad_alloc();
+        }
       }
       else
       {
-        throw std::bad_alloc();
+        matrixFile = new int[rows * cols]();
       }
-    }
-    else
-    {
-      matrixFile = new int[rows * cols]();
-    }
 
-    if (!stu::readArr(input, rows, cols, matrixFile))
-    {
-      std::cerr << "Non-correct values of matrix elements\n";
-      if (firstArg[0] == '2')
+      if (!stu::readArr(input, rows, cols, matrixFile))
       {
-        delete [] matrixFile;
+        std::cerr << "Non-correct values of matrix elements\n";
+        if (firstArg[0] == '2')
+        {
+          delete [] matrixFile;
+        }
+        return 2;
       }
-      return 2;
+      input.close();
+      source = matrixFile;
     }
-    input.close();
+    stupir::AllocPhase computePhase("compute");
     matrixChange = new int[rows * cols]();
     if (rows != 0 && cols != 0)
     {
-      stu::addSnail(matrixFile, rows, cols, matrixChange);
+      stu::addSnail(source, rows, cols, matrixChange);
+    }
+    numDigNotNull = stu::countNotZeroD(source, rows, cols);
+  }
+  catch (const std::overflow_error & e)
+  {
+    if (firstArg[0] == '2')
+    {
+      delete [] matrixFile;
     }
-    numDigNotNull = stu::countNotZeroD(matrixFile, rows, cols);
+    delete [] matrixChange;
+    std::cerr << e.what() << "\n";
+    return 2;
   }
   catch (const std::bad_alloc & e)
   {
-    delete [] matrixFile;
+    if (firstArg[0] == '2')
+    {
+      delete [] matrixFile;
+    }
     delete [] matrixChange;
     std::cerr << "Not enough memory\n";
     return 2;
   }
-  std::ofstream output(thirdArg);
-  if (rows != 0 && cols != 0)
+  stupir::AllocPhase writePhase("write");
+  const bool writeBehind = std::getenv("STUPIR_WRITE_BEHIND") != nullptr;
+  const bool npyOutput = stupir::isNpyPath(thirdArg);
+  std::ofstream file;
+  std::unique_ptr< stupir::WriteBehindBuf > behindBuf;
+  std::ostream behind(nullptr);
+  if (writeBehind)
   {
-    output << rows << " " << cols << " ";
-    stu::writeArr(output, rows, cols, matrixChange);
+    behindBuf.reset(new stupir::WriteBehindBuf());
+    behind.rdbuf(behindBuf.get());
+    if (!behindBuf->open(thirdArg))
+    {
+      behindBuf.reset();
+      behind.rdbuf(nullptr);
+    }
   }
   else
   {
-    output << rows << " " << cols;
+    file.open(thirdArg, npyOutput ? std::ios::out | std::ios::binary : std::ios::out);
+  }
+  std::ostream & output = writeBehind ? behind : file;
+  if (npyOutput)
+  {
+    stu::writeNpy(output, matrixChange, rows, cols);
+    std::cout << numDigNotNull << "\n";
+  }
+  else
+  {
+    if (rows != 0 && cols != 0)
+    {
+      output << rows << " " << cols << " ";
+      stu::writeArr(output, rows, cols, matrixChange);
+    }
+    else
+    {
+      output << rows << " " << cols;
+    }
+    output << "\n" << numDigNotNull;
+  }
+  int status = 0;
+  if (behindBuf && !behindBuf->close())
+  {
+    std::cerr << "Error when writing the output file\n";
+    status = 2;
   }
-  output << "\n" << numDigNotNull;
 
   if (firstArg[0] == '2')
   {
     delete [] matrixFile;
   }
   delete [] matrixChange;
+  return status;
 }
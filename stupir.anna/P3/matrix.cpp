@@ -0,0 +1,129 @@
+#include "matrix.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace stupir
+{
+  bool checkAddSnail(size_t up, size_t down, size_t left, size_t right)
+  {
+    return (up <= down && left <= right);
+  }
+
+  void addSpan(const int * arr1, int * arr2, size_t cols, size_t start, std::ptrdiff_t step, size_t count, size_t & sum)
+  {
+    const int * src = arr1 + start;
+    int * dst = arr2 + start;
+    const long long base = static_cast< long long >(sum);
+    size_t first = count;
+    for (size_t k = 0; k < count; ++k)
+    {
+      std::ptrdiff_t idx = static_cast< std::ptrdiff_t >(k) * step;
+      long long value = dst[idx] + static_cast< long long >(src[idx]) + base + static_cast< long long >(k);
+      bool overflow = value > std::numeric_limits< int >::max() || value < std::numeric_limits< int >::min();
+      dst[idx] = static_cast< int >(value);
+      first = std::min(first, overflow ? k : count);
+    }
+    sum += count;
+    if (first != count)
+    {
+      size_t cell = start + static_cast< std::ptrdiff_t >(first) * step;
+      throw std::overflow_error("Snail addition overflow at " + std::to_string(cell / cols) + " " + std::to_string(cell % cols));
+    }
+  }
+
+  void addSnail(const int * arr1, size_t rows, size_t cols, int * arr2)
+  {
+    size_t sum = 1;
+    size_t left = 0;
+    size_t right = cols - 1;
+    size_t up = 0;
+    size_t down = rows - 1;
+    const std::ptrdiff_t stride = static_cast< std::ptrdiff_t >(cols);
+    while (checkAddSnail(up, down, left, right))
+    {
+      addSpan(arr1, arr2, cols, cols * down + left, 1, right - left + 1, sum);
+      if (down == up)
+      {
+        break;
+      }
+      down--;
+
+      if (!checkAddSnail(up, down, left, right))
+      {
+        break;
+      }
+
+      addSpan(arr1, arr2, cols, cols * down + right, -stride, down - up + 1, sum);
+      if (right == left)
+      {
+        break;
+      }
+      right--;
+
+      if (!checkAddSnail(up, down, left, right))
+      {
+        break;
+      }
+
+      addSpan(arr1, arr2, cols, cols * up + right, -1, right - left + 1, sum);
+      up++;
+
+      if (!checkAddSnail(up, down, left, right))
+      {
+        break;
+      }
+
+      addSpan(arr1, arr2, cols, cols * up + left, stride, down - up + 1, sum);
+      left++;
+    }
+  }
+
+  size_t countNotZeroD(const int * arr, size_t rows, size_t cols)
+  {
+    size_t result = 0;
+    if (rows == 0 && cols == 0)
+    {
+      return 0;
+    }
+    for (size_t k = 0; k < rows; ++k)
+    {
+      size_t num = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+        if (i - k < cols)
+        {
+          if (arr[cols * i + i - k] == 0)
+          {
+            num++;
+          }
+        }
+      }
+      if (num == 0)
+      {
+        result++;
+      }
+    }
+
+    for (size_t k = 1; k < cols; ++k)
+    {
+      size_t num = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+        if (i + k < cols)
+        {
+          if (arr[cols * i + i + k] == 0)
+          {
+            num++;
+          }
+        }
+      }
+      if (num == 0)
+      {
+        result++;
+      }
+    }
+    return result;
+  }
+}
@@ -0,0 +1,14 @@
+#ifndef STUPIR_MATRIX_HPP
+#define STUPIR_MATRIX_HPP
+
+#include <cstddef>
+
+namespace stupir
+{
+  bool checkAddSnail(size_t up, size_t down, size_t left, size_t right);
+  void addSpan(const int * arr1, int * arr2, size_t cols, size_t start, std::ptrdiff_t step, size_t count, size_t & sum);
+  void addSnail(const int * arr1, size_t rows, size_t cols, int * arr2);
+  size_t countNotZeroD(const int * arr, size_t rows, size_t cols);
+}
+
+#endif
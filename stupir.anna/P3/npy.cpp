@@ -0,0 +1,317 @@
+#include "npy.hpp"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stupir
+{
+  namespace
+  {
+    const char NPY_MAGIC[] = "\x93NUMPY";
+    const size_t NPY_MAGIC_SIZE = 6;
+    const size_t NPY_ALIGN = 64;
+
+    struct NpyHeader
+    {
+      char kind;
+      size_t itemSize;
+      bool bigEndian;
+      bool fortranOrder;
+      size_t rows;
+      size_t cols;
+      size_t dataOffset;
+    };
+
+    bool isLittleEndian()
+    {
+      const uint16_t probe = 1;
+      return *reinterpret_cast< const unsigned char * >(&probe) == 1;
+    }
+
+    void badHeader(const std::string & what)
+    {
+      throw std::runtime_error("Unsupported .npy header: " + what);
+    }
+
+    size_t findValue(const std::string & dict, const char * key)
+    {
+      for (char quote: {'\'', '"'})
+      {
+        std::string quoted = quote + std::string(key) + quote;
+        size_t pos = dict.find(quoted);
+        if (pos != std::string::npos)
+        {
+          pos = dict.find(':', pos + quoted.size());
+          pos = pos == std::string::npos ? pos : dict.find_first_not_of(' ', pos + 1);
+          if (pos != std::string::npos)
+          {
+            return pos;
+          }
+        }
+      }
+      badHeader(std::string("no ") + key);
+      return 0;
+    }
+
+    size_t readSize(const std::string & dict, size_t & pos)
+    {
+      size_t first = pos;
+      size_t value = 0;
+      while (pos < dict.size() && dict[pos] >= '0' && dict[pos] <= '9')
+      {
+        if (value > (std::numeric_limits< size_t >::max() - 9) / 10)
+        {
+          badHeader("shape is too large");
+        }
+        value = value * 10 + static_cast< size_t >(dict[pos] - '0');
+        ++pos;
+      }
+      if (pos == first)
+      {
+        badHeader("bad shape");
+      }
+      pos += pos < dict.size() && dict[pos] == 'L';
+      return value;
+    }
+
+    void parseDict(const std::string & dict, NpyHeader & header)
+    {
+      size_t pos = findValue(dict, "descr");
+      if (dict[pos] != '\'' && dict[pos] != '"')
+      {
+        badHeader("descr is not a simple type");
+      }
+      size_t end = dict.find(dict[pos], pos + 1);
+      std::string descr = dict.substr(pos + 1, end == std::string::npos ? 0 : end - pos - 1);
+      if (descr.size() < 3 || (descr[1] != 'i' && descr[1] != 'u'))
+      {
+        badHeader("descr '" + descr + "'");
+      }
+      char order = descr[0];
+      header.kind = descr[1];
+      header.itemSize = descr.substr(2) == "1" ? 1 : descr.substr(2) == "2" ? 2 : 0;
+      header.itemSize = descr.substr(2) == "4" ? 4 : descr.substr(2) == "8" ? 8 : header.itemSize;
+      if (header.itemSize == 0 || (order != '<' && order != '>' && order != '|' && order != '='))
+      {
+        badHeader("descr '" + descr + "'");
+      }
+      header.bigEndian = order == '>' || (order == '=' && !isLittleEndian());
+
+      pos = findValue(dict, "fortran_order");
+      header.fortranOrder = dict.compare(pos, 4, "True") == 0;
+      if (!header.fortranOrder && dict.compare(pos, 5, "False") != 0)
+      {
+        badHeader("bad fortranOrder");
+      }
+
+      pos = findValue(dict, "shape");
+      if (dict[pos] != '(')
+      {
+        badHeader("bad shape");
+      }
+      pos = dict.find_first_not_of(' ', pos + 1);
+      header.rows = readSize(dict, pos);
+      pos = dict.find_first_not_of(' ', pos);
+      if (pos == std::string::npos || dict[pos] != ',')
+      {
+        badHeader("matrix must be two-dimensional");
+      }
+      pos = dict.find_first_not_of(' ', pos + 1);
+      header.cols = readSize(dict, pos);
+      pos = dict.find_first_not_of(' ', pos);
+      pos += pos != std::string::npos && dict[pos] == ',';
+      pos = dict.find_first_not_of(' ', pos);
+      if (pos == std::string::npos || dict[pos] != ')')
+      {
+        badHeader("matrix must be two-dimensional");
+      }
+    }
+
+    NpyHeader parseHeader(const unsigned char * file, size_t size)
+    {
+      if (size < NPY_MAGIC_SIZE + 4 || std::memcmp(file, NPY_MAGIC, NPY_MAGIC_SIZE) != 0)
+      {
+        throw std::runtime_error("Input file is not a .npy file");
+      }
+      unsigned major = file[NPY_MAGIC_SIZE];
+      size_t lenSize = major == 1 ? 2 : 4;
+      if (major < 1 || major > 3 || size < NPY_MAGIC_SIZE + 2 + lenSize)
+      {
+        badHeader("version " + std::to_string(major));
+      }
+      size_t dictSize = 0;
+      for (size_t b = 0; b < lenSize; ++b)
+      {
+        dictSize |= static_cast< size_t >(file[NPY_MAGIC_SIZE + 2 + b]) << (8 * b);
+      }
+      size_t dictStart = NPY_MAGIC_SIZE + 2 + lenSize;
+      if (dictSize > size - dictStart)
+      {
+        badHeader("truncated");
+      }
+      NpyHeader header{0, 0, false, false, 0, 0, dictStart + dictSize};
+      parseDict(std::string(reinterpret_cast< const char * >(file) + dictStart, dictSize), header);
+      size_t count = header.rows * header.cols;
+      if (header.rows && count / header.rows != header.cols)
+      {
+        badHeader("shape is too large");
+      }
+      if (count > (size - header.dataOffset) / header.itemSize)
+      {
+        throw std::runtime_error("Input .npy payload is shorter than its shape");
+      }
+      return header;
+    }
+
+    int readItem(const unsigned char * p, const NpyHeader & header, size_t index)
+    {
+      size_t size = header.itemSize;
+      unsigned long long bits = 0;
+      for (size_t b = 0; b < size; ++b)
+      {
+        size_t shift = header.bigEndian ? size - 1 - b : b;
+        bits |= static_cast< unsigned long long >(p[b]) << (8 * shift);
+      }
+      bool negative = header.kind == 'i' && ((bits >> (8 * size - 1)) & 1);
+      if (negative && size < 8)
+      {
+        bits |= ~0ULL << (8 * size);
+      }
+      const unsigned long long intMax = std::numeric_limits< int >::max();
+      bool fits = negative ? ~bits <= intMax : bits <= intMax;
+      if (!fits)
+      {
+        throw std::overflow_error("Value out of int range in .npy input at element " + std::to_string(index));
+      }
+      return negative ? -static_cast< int >(~bits) - 1 : static_cast< int >(bits);
+    }
+  }
+}
+
+bool stupir::isNpyPath(const char * path)
+{
+  size_t len = std::strlen(path);
+  return len >= 4 && std::strcmp(path + len - 4, ".npy") == 0;
+}
+
+stupir::NpyMatrix::NpyMatrix():
+  map_(nullptr),
+  mapSize_(0),
+  data_(nullptr),
+  rows_(0),
+  cols_(0)
+{}
+
+stupir::NpyMatrix::~NpyMatrix()
+{
+  close();
+}
+
+void stupir::NpyMatrix::close()
+{
+  if (map_)
+  {
+    ::munmap(map_, mapSize_);
+  }
+  map_ = nullptr;
+  mapSize_ = 0;
+  data_ = nullptr;
+  converted_.clear();
+}
+
+void stupir::NpyMatrix::open(const char * path)
+{
+  close();
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || ::fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+    throw std::runtime_error("Can't open .npy input file");
+  }
+  mapSize_ = static_cast< size_t >(st.st_size);
+  // addSnail only reads the source matrix, so the payload is mapped read-only
+  void * map = ::mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+  {
+    mapSize_ = 0;
+    throw std::runtime_error("Can't map .npy input file");
+  }
+  map_ = map;
+
+  const unsigned char * file = static_cast< const unsigned char * >(map_);
+  NpyHeader header = parseHeader(file, mapSize_);
+  rows_ = header.rows;
+  cols_ = header.cols;
+  const unsigned char * payload = file + header.dataOffset;
+  bool native = header.bigEndian != isLittleEndian() || header.itemSize == 1;
+  bool direct = header.kind == 'i' && header.itemSize == sizeof(int) && native && !header.fortranOrder;
+  if (direct && header.dataOffset % alignof(int) == 0)
+  {
+    data_ = reinterpret_cast< const int * >(payload);
+    return;
+  }
+
+  converted_.resize(rows_ * cols_);
+  for (size_t i = 0; i < rows_; ++i)
+  {
+    for (size_t j = 0; j < cols_; ++j)
+    {
+      size_t index = header.fortranOrder ? j * rows_ + i : i * cols_ + j;
+      converted_[i * cols_ + j] = readItem(payload + index * header.itemSize, header, index);
+    }
+  }
+  data_ = converted_.data();
+  ::munmap(map_, mapSize_);
+  map_ = nullptr;
+  mapSize_ = 0;
+}
+
+size_t stupir::NpyMatrix::rows() const
+{
+  return rows_;
+}
+
+size_t stupir::NpyMatrix::cols() const
+{
+  return cols_;
+}
+
+const int * stupir::NpyMatrix::data() const
+{
+  return data_;
+}
+
+std::ostream & stupir::writeNpy(std::ostream & output, const int * arr, size_t rows, size_t cols)
+{
+  std::string dict = "{'descr': '";
+  dict += isLittleEndian() ? '<' : '>';
+  dict += "i" + std::to_string(sizeof(int)) + "', 'fortran_order': False, 'shape': (";
+  dict += std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+  size_t prefix = NPY_MAGIC_SIZE + 4;
+  dict.append(NPY_ALIGN - 1 - (prefix + dict.size()) % NPY_ALIGN, ' ');
+  dict += '\n';
+
+  output.write(NPY_MAGIC, NPY_MAGIC_SIZE);
+  output.put(1);
+  output.put(0);
+  output.put(static_cast< char >(dict.size() & 0xFF));
+  output.put(static_cast< char >(dict.size() >> 8));
+  output << dict;
+  if (rows > 0 && cols > 0)
+  {
+    output.write(reinterpret_cast< const char * >(arr), static_cast< std::streamsize >(rows * cols * sizeof(int)));
+  }
+  return output;
+}
@@ -0,0 +1,212 @@
+#include "write_behind.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace stupir
+{
+  namespace
+  {
+    bool writeAll(int fd, const char * data, size_t size, size_t offset)
+    {
+      while (size)
+      {
+        ssize_t n = ::pwrite(fd, data, size, static_cast< off_t >(offset));
+        if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (n <= 0)
+        {
+          return false;
+        }
+        data += n;
+        size -= static_cast< size_t >(n);
+        offset += static_cast< size_t >(n);
+      }
+      return true;
+    }
+  }
+}
+
+const size_t stupir::WriteBehindBuf::alignment;
+
+stupir::WriteBehindBuf::WriteBehindBuf(size_t blockSize, size_t blocks):
+  blockSize_((blockSize + alignment - 1) / alignment * alignment),
+  fd_(-1),
+  direct_(false),
+  stop_(false),
+  failed_(false)
+{
+  for (size_t i = 0; i < blocks || i < 2; ++i)
+  {
+    void * p = nullptr;
+    if (::posix_memalign(&p, alignment, blockSize_) != 0)
+    {
+      break;
+    }
+    blocks_.push_back(static_cast< char * >(p));
+    free_.push_back(blocks_.back());
+  }
+}
+
+stupir::WriteBehindBuf::~WriteBehindBuf()
+{
+  close();
+  for (char * block: blocks_)
+  {
+    std::free(block);
+  }
+}
+
+bool stupir::WriteBehindBuf::open(const char * path)
+{
+  if (fd_ >= 0 || blocks_.size() < 2)
+  {
+    return false;
+  }
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+  fd_ = ::open(path, flags | O_DIRECT, 0644);
+  direct_ = fd_ >= 0;
+#endif
+  if (fd_ < 0)
+  {
+    fd_ = ::open(path, flags, 0644);
+  }
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  stop_ = false;
+  failed_ = false;
+  take();
+  writer_ = std::thread(&WriteBehindBuf::run, this);
+  return true;
+}
+
+bool stupir::WriteBehindBuf::close()
+{
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  if (pptr() != pbase())
+  {
+    submit();
+  }
+  else if (pbase())
+  {
+    std::lock_guard< std::mutex > lock(mutex_);
+    free_.push_back(pbase());
+  }
+  setp(nullptr, nullptr);
+  {
+    std::lock_guard< std::mutex > lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+  bool ok = ::close(fd_) == 0 && !failed_;
+  fd_ = -1;
+  return ok;
+}
+
+stupir::WriteBehindBuf::int_type stupir::WriteBehindBuf::overflow(int_type ch)
+{
+  if (fd_ < 0)
+  {
+    return traits_type::eof();
+  }
+  submit();
+  take();
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+void stupir::WriteBehindBuf::submit()
+{
+  {
+    std::lock_guard< std::mutex > lock(mutex_);
+    pending_.push_back(Block{pbase(), static_cast< size_t >(pptr() - pbase())});
+  }
+  cv_.notify_all();
+  setp(nullptr, nullptr);
+}
+
+void stupir::WriteBehindBuf::take()
+{
+  std::unique_lock< std::mutex > lock(mutex_);
+  cv_.wait(lock, [this]()
+  {
+    return !free_.empty();
+  });
+  char * block = free_.back();
+  free_.pop_back();
+  setp(block, block + blockSize_);
+}
+
+void stupir::WriteBehindBuf::run()
+{
+  size_t offset = 0;
+  std::unique_lock< std::mutex > lock(mutex_);
+  while (true)
+  {
+    cv_.wait(lock, [this]()
+    {
+      return stop_ || !pending_.empty();
+    });
+    if (pending_.empty())
+    {
+      return;
+    }
+    Block block = pending_.front();
+    pending_.pop_front();
+    lock.unlock();
+    bool ok = writeBlock(block, offset);
+    offset += block.size;
+    lock.lock();
+    failed_ = failed_ || !ok;
+    free_.push_back(block.data);
+    cv_.notify_all();
+  }
+}
+
+bool stupir::WriteBehindBuf::writeBlock(const Block & block, size_t offset)
+{
+#ifdef O_DIRECT
+  if (direct_ && block.size % alignment != 0)
+  {
+    // Only the last block can be short; finish the file through the cache.
+    int flags = ::fcntl(fd_, F_GETFL);
+    if (flags < 0 || ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT) != 0)
+    {
+      return false;
+    }
+    direct_ = false;
+  }
+#endif
+  if (!writeAll(fd_, block.data, block.size, offset))
+  {
+    return false;
+  }
+#ifdef __linux__
+  if (!direct_ && block.size)
+  {
+    ::sync_file_range(fd_, static_cast< off_t >(offset), static_cast< off_t >(block.size), SYNC_FILE_RANGE_WRITE);
+    if (offset >= blockSize_)
+    {
+      off_t prev = static_cast< off_t >(offset - blockSize_);
+      unsigned wait = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+      ::sync_file_range(fd_, prev, static_cast< off_t >(blockSize_), wait);
+      ::posix_fadvise(fd_, prev, static_cast< off_t >(blockSize_), POSIX_FADV_DONTNEED);
+    }
+  }
+#endif
+  return true;
+}
@@ -0,0 +1,60 @@
+#ifndef STUPIR_WRITE_BEHIND_HPP
+#define STUPIR_WRITE_BEHIND_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace stupir
+{
+  // Output buffer whose filled, page-aligned blocks are written by a
+  // background thread. The file is opened with O_DIRECT when the file
+  // system allows it; otherwise writes are buffered and pushed out with
+  // sync_file_range, dropping written pages from the cache.
+  class WriteBehindBuf: public std::streambuf
+  {
+  public:
+    static const size_t alignment = 4096;
+
+    explicit WriteBehindBuf(size_t blockSize = 1 << 20, size_t blocks = 4);
+    ~WriteBehindBuf();
+    WriteBehindBuf(const WriteBehindBuf &) = delete;
+    WriteBehindBuf & operator=(const WriteBehindBuf &) = delete;
+
+    bool open(const char * path);
+    bool close();
+
+  protected:
+    int_type overflow(int_type ch) override;
+
+  private:
+    struct Block
+    {
+      char * data;
+      size_t size;
+    };
+
+    size_t blockSize_;
+    std::vector< char * > blocks_;
+    std::vector< char * > free_;
+    std::deque< Block > pending_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread writer_;
+    int fd_;
+    bool direct_;
+    bool stop_;
+    bool failed_;
+
+    void submit();
+    void take();
+    void run();
+    bool writeBlock(const Block & block, size_t offset);
+  };
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "batch.hpp"
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+void zharov::packBatch(MatrixBatch & batch, const std::vector< const int * > & mtxs, size_t rows, size_t cols)
+{
+  size_t size = rows * cols;
+  batch.rows = rows;
+  batch.cols = cols;
+  batch.count = std::min(mtxs.size(), BATCH_LANES);
+  batch.soa.assign(size * BATCH_LANES, 0);
+  for (size_t lane = 0; lane < batch.count; ++lane) {
+    const int * mtx = mtxs[lane];
+    for (size_t k = 0; k < size; ++k) {
+      batch.soa[k * BATCH_LANES + lane] = mtx[k];
+    }
+  }
+}
+
+void zharov::isUppTriMtxBatch(const MatrixBatch & batch, bool * res)
+{
+  size_t n = std::min(batch.rows, batch.cols);
+  unsigned char ok[BATCH_LANES];
+  std::fill(ok, ok + BATCH_LANES, n != 0);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      const int * cell = batch.soa.data() + (n * i + j) * BATCH_LANES;
+      for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+        ok[lane] &= cell[lane] == 0;
+      }
+    }
+  }
+  for (size_t lane = 0; lane < batch.count; ++lane) {
+    res[lane] = ok[lane];
+  }
+}
+
+void zharov::getCntColNsmBatch(const MatrixBatch & batch, size_t * res)
+{
+  size_t rows = batch.rows;
+  size_t cols = batch.cols;
+  size_t cnt[BATCH_LANES] = {};
+  for (size_t i = 0; rows && i < cols; ++i) {
+    unsigned char repeats[BATCH_LANES] = {};
+    for (size_t j = 1; j < rows; ++j) {
+      const int * upper = batch.soa.data() + ((j - 1) * cols + i) * BATCH_LANES;
+      const int * lower = upper + cols * BATCH_LANES;
+      for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+        repeats[lane] |= upper[lane] == lower[lane];
+      }
+    }
+    for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+      cnt[lane] += !repeats[lane];
+    }
+  }
+  std::copy(cnt, cnt + batch.count, res);
+}
+
+void zharov::processBatch(const MatrixBatch & batch, BatchResult * res)
+{
+  bool uppTri[BATCH_LANES] = {};
+  size_t cntColNsm[BATCH_LANES] = {};
+  isUppTriMtxBatch(batch, uppTri);
+  getCntColNsmBatch(batch, cntColNsm);
+  for (size_t lane = 0; lane < batch.count; ++lane) {
+    res[lane] = {uppTri[lane], cntColNsm[lane]};
+  }
+}
+
+std::istream & zharov::inputBatchMatrix(std::istream & input, std::vector< int > & mtx, size_t & rows, size_t & cols)
+{
+  if (!(input >> rows >> cols)) {
+    return input;
+  }
+  if (cols && rows > std::numeric_limits< size_t >::max() / cols) {
+    input.setstate(std::ios::failbit);
+    return input;
+  }
+  mtx.resize(rows * cols);
+  for (size_t i = 0; input && i < rows * cols; ++i) {
+    input >> mtx[i];
+  }
+  return input;
+}
+
+int zharov::processStream(std::istream & input, std::ostream & output)
+{
+  std::vector< std::vector< int > > group;
+  std::vector< const int * > ptrs;
+  MatrixBatch batch{0, 0, 0, {}};
+  BatchResult res[BATCH_LANES] = {};
+  size_t rows = 0, cols = 0;
+  auto flush = [&]() {
+    ptrs.clear();
+    for (const std::vector< int > & mtx: group) {
+      ptrs.push_back(mtx.data());
+    }
+    packBatch(batch, ptrs, rows, cols);
+    processBatch(batch, res);
+    for (size_t lane = 0; lane < batch.count; ++lane) {
+      output << res[lane].uppTri << "\n" << res[lane].cntColNsm << "\n";
+    }
+    group.clear();
+  };
+  std::vector< int > mtx;
+  size_t r = 0, c = 0;
+  while (input >> std::ws && !input.eof()) {
+    if (!inputBatchMatrix(input, mtx, r, c)) {
+      if (!group.empty()) {
+        flush();
+      }
+      return 2;
+    }
+    if (!group.empty() && (r != rows || c != cols || group.size() == BATCH_LANES)) {
+      flush();
+    }
+    rows = r;
+    cols = c;
+    group.push_back(mtx);
+  }
+  if (!group.empty()) {
+    flush();
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef ZHAROV_BATCH_HPP
+#define ZHAROV_BATCH_HPP
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace zharov
+{
+  constexpr size_t BATCH_LANES = 16;
+
+  struct BatchResult {
+    bool uppTri;
+    size_t cntColNsm;
+  };
+
+  struct MatrixBatch {
+    size_t rows;
+    size_t cols;
+    size_t count;
+    std::vector< int > soa;
+  };
+
+  void packBatch(MatrixBatch & batch, const std::vector< const int * > & mtxs, size_t rows, size_t cols);
+  void isUppTriMtxBatch(const MatrixBatch & batch, bool * res);
+  void getCntColNsmBatch(const MatrixBatch & batch, size_t * res);
+  void processBatch(const MatrixBatch & batch, BatchResult * res);
+
+  std::istream & inputBatchMatrix(std::istream & input, std::vector< int > & mtx, size_t & rows, size_t & cols);
+  int processStream(std::istream & input, std::ostream & output);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "capi.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+#include "matrix.hpp"
+
+namespace zharov
+{
+  namespace
+  {
+    bool isValid(const int * mtx, size_t stride, size_t rows, size_t cols)
+    {
+      return rows == 0 || cols == 0 || (mtx && stride >= cols);
+    }
+
+    const int * makeDense(const int * mtx, size_t stride, size_t rows, size_t cols, std::vector< int > & buf)
+    {
+      if (stride == cols || rows == 0 || cols == 0) {
+        return mtx;
+      }
+      buf.resize(rows * cols);
+      for (size_t i = 0; i < rows; ++i) {
+        std::copy(mtx + i * stride, mtx + i * stride + cols, buf.data() + i * cols);
+      }
+      return buf.data();
+    }
+  }
+}
+
+unsigned zharov_capiVersion(void)
+{
+  return ZHAROV_CAPI_VERSION;
+}
+
+int zharov_isUppTriMtx(const int * mtx, size_t stride, size_t rows, size_t cols, int * result)
+{
+  if (!zharov::isValid(mtx, stride, rows, cols) || !result) {
+    return ZHAROV_EINVAL;
+  }
+  try {
+    std::vector< int > buf;
+    *result = zharov::isUppTriMtx(zharov::makeDense(mtx, stride, rows, cols, buf), rows, cols);
+  } catch (const std::bad_alloc &) {
+    return ZHAROV_ENOMEM;
+  }
+  return ZHAROV_OK;
+}
+
+int zharov_getCntColNsm(const int * mtx, size_t stride, size_t rows, size_t cols, size_t * result)
+{
+  if (!zharov::isValid(mtx, stride, rows, cols) || !result) {
+    return ZHAROV_EINVAL;
+  }
+  try {
+    std::vector< int > buf;
+    *result = zharov::getCntColNsm(zharov::makeDense(mtx, stride, rows, cols, buf), rows, cols);
+  } catch (const std::bad_alloc &) {
+    return ZHAROV_ENOMEM;
+  }
+  return ZHAROV_OK;
+}
@@ -0,0 +1,30 @@
+#ifndef ZHAROV_CAPI_H
+#define ZHAROV_CAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ZHAROV_CAPI_VERSION 1
+
+#define ZHAROV_OK 0
+#define ZHAROV_EINVAL 1
+#define ZHAROV_ENOMEM 3
+
+/*
+ * mtx points at a caller-owned rows x cols row-major matrix whose rows are
+ * stride elements apart (stride >= cols). Results match the lab output.
+ */
+
+unsigned zharov_capiVersion(void);
+int zharov_isUppTriMtx(const int * mtx, size_t stride, size_t rows, size_t cols, int * result);
+int zharov_getCntColNsm(const int * mtx, size_t stride, size_t rows, size_t cols, size_t * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+#include "col_queries.hpp"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+namespace zharov
+{
+  namespace
+  {
+    class Fenwick {
+    public:
+      explicit Fenwick(size_t size):
+        tree_(size + 1, 0)
+      {}
+
+      void add(size_t pos, long long delta)
+      {
+        for (++pos; pos < tree_.size(); pos += pos & (~pos + 1)) {
+          tree_[pos] += delta;
+        }
+      }
+
+      long long prefix(size_t end) const
+      {
+        long long res = 0;
+        for (; end > 0; end -= end & (~end + 1)) {
+          res += tree_[end];
+        }
+        return res;
+      }
+
+    private:
+      std::vector< long long > tree_;
+    };
+
+    bool isValid(const RowRange & range, size_t rows)
+    {
+      return range.begin <= range.end && range.end <= rows;
+    }
+  }
+}
+
+void zharov::buildRepeatIndex(const int * mtx, size_t rows, size_t cols, RepeatIndex & index)
+{
+  index.rows = rows;
+  index.cols = cols;
+  index.rowStart.assign(1, 0);
+  index.repeatCols.clear();
+  for (size_t p = 0; p < rows; ++p) {
+    for (size_t j = 0; p && j < cols; ++j) {
+      if (mtx[p * cols + j] == mtx[(p - 1) * cols + j]) {
+        index.repeatCols.push_back(static_cast< uint32_t >(j));
+      }
+    }
+    index.rowStart.push_back(index.repeatCols.size());
+  }
+}
+
+void zharov::getCntColNsmRanges(const RepeatIndex & index, const std::vector< RowRange > & ranges, std::vector< size_t > & res)
+{
+  const size_t rows = index.rows;
+  const size_t cols = index.cols;
+  res.assign(ranges.size(), 0);
+  std::vector< size_t > order;
+  for (size_t q = 0; q < ranges.size(); ++q) {
+    if (isValid(ranges[q], rows) && ranges[q].begin < ranges[q].end && cols) {
+      order.push_back(q);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&ranges](size_t a, size_t b) {
+    return ranges[a].begin > ranges[b].begin;
+  });
+
+  // Sweep the range start upwards from the bottom. next[j] is the first
+  // repeat of column j strictly below the current start, rows if none;
+  // the Fenwick tree counts columns by that position.
+  std::vector< size_t > next(cols, rows);
+  Fenwick count(rows + 1);
+  count.add(rows, static_cast< long long >(cols));
+  size_t begin = rows;
+  for (size_t q: order) {
+    while (begin > ranges[q].begin) {
+      --begin;
+      size_t p = begin + 1;
+      for (size_t k = p < rows ? index.rowStart[p] : 0; p < rows && k < index.rowStart[p + 1]; ++k) {
+        uint32_t j = index.repeatCols[k];
+        count.add(next[j], -1);
+        next[j] = p;
+        count.add(p, 1);
+      }
+    }
+    res[q] = cols - count.prefix(ranges[q].end);
+  }
+}
+
+std::istream & zharov::inputRowRanges(std::istream & input, std::vector< RowRange > & ranges)
+{
+  RowRange range{0, 0};
+  while (input >> range.begin >> range.end) {
+    ranges.push_back(range);
+  }
+  return input;
+}
+
+std::ostream & zharov::processColQueries(std::istream & input, std::ostream & output, const int * mtx, size_t rows, size_t cols)
+{
+  std::vector< RowRange > ranges;
+  zharov::inputRowRanges(input, ranges);
+  RepeatIndex index{0, 0, {}, {}};
+  zharov::buildRepeatIndex(mtx, rows, cols, index);
+  std::vector< size_t > res;
+  zharov::getCntColNsmRanges(index, ranges, res);
+  for (size_t q = 0; q < ranges.size(); ++q) {
+    if (isValid(ranges[q], rows)) {
+      output << res[q] << "\n";
+    } else {
+      output << "-\n";
+    }
+  }
+  return output;
+}
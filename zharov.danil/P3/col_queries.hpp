@@ -0,0 +1,32 @@
+#ifndef ZHAROV_COL_QUERIES_HPP
+#define ZHAROV_COL_QUERIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace zharov
+{
+  struct RowRange {
+    size_t begin;
+    size_t end;
+  };
+
+  // Columns that repeat between rows p - 1 and p, grouped by p.
+  // A column counts for rows [a, b) if it has no repeat at any p in (a, b).
+  struct RepeatIndex {
+    size_t rows;
+    size_t cols;
+    std::vector< size_t > rowStart;
+    std::vector< uint32_t > repeatCols;
+  };
+
+  void buildRepeatIndex(const int * mtx, size_t rows, size_t cols, RepeatIndex & index);
+  void getCntColNsmRanges(const RepeatIndex & index, const std::vector< RowRange > & ranges, std::vector< size_t > & res);
+
+  std::istream & inputRowRanges(std::istream & input, std::vector< RowRange > & ranges);
+  std::ostream & processColQueries(std::istream & input, std::ostream & output, const int * mtx, size_t rows, size_t cols);
+}
+
+#endif
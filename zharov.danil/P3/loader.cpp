@@ -0,0 +1,486 @@
+#include "loader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ZHAROV_HAS_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace zharov
+{
+  namespace
+  {
+    const size_t READ_CHUNK = 64 * 1024;
+
+    size_t getEnvSize(const char * name, size_t def)
+    {
+      const char * value = std::getenv(name);
+      if (!value || !*value) {
+        return def;
+      }
+      char * end = nullptr;
+      unsigned long long res = std::strtoull(value, &end, 10);
+      return (*end == '\0' && res) ? static_cast< size_t >(res) : def;
+    }
+
+    bool readFile(const std::string & path, std::vector< char > & buf)
+    {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        return false;
+      }
+      struct stat st = {};
+      size_t cap = (::fstat(fd, &st) == 0 && st.st_size > 0) ? static_cast< size_t >(st.st_size) + 1 : READ_CHUNK;
+      buf.resize(cap);
+      size_t len = 0;
+      bool ok = true;
+      while (true) {
+        if (len == buf.size()) {
+          buf.resize(buf.size() * 2);
+        }
+        ssize_t res = ::read(fd, buf.data() + len, buf.size() - len);
+        if (res < 0 && errno == EINTR) {
+          continue;
+        }
+        if (res <= 0) {
+          ok = res == 0;
+          break;
+        }
+        len += static_cast< size_t >(res);
+      }
+      ::close(fd);
+      buf.resize(len);
+      return ok;
+    }
+
+#ifdef ZHAROV_HAS_URING
+    enum UringOp: uint64_t {
+      OP_OPEN,
+      OP_READ,
+      OP_CLOSE
+    };
+
+    struct Uring {
+      int fd;
+      unsigned * sqHead;
+      unsigned * sqTail;
+      unsigned sqMask;
+      unsigned * sqArray;
+      unsigned * cqHead;
+      unsigned * cqTail;
+      unsigned cqMask;
+      io_uring_sqe * sqes;
+      io_uring_cqe * cqes;
+      void * sqRing;
+      size_t sqSize;
+      void * cqRing;
+      size_t cqSize;
+      size_t sqesSize;
+      unsigned pending;
+    };
+
+    struct UringSlot {
+      size_t index;
+      int fd;
+      size_t len;
+      std::vector< char > buf;
+    };
+
+    template< class T >
+    T * ringField(void * ring, unsigned offset)
+    {
+      return reinterpret_cast< T * >(static_cast< char * >(ring) + offset);
+    }
+
+    void closeUring(Uring & ring)
+    {
+      if (ring.sqes) {
+        ::munmap(ring.sqes, ring.sqesSize);
+      }
+      if (ring.cqRing && ring.cqRing != ring.sqRing) {
+        ::munmap(ring.cqRing, ring.cqSize);
+      }
+      if (ring.sqRing) {
+        ::munmap(ring.sqRing, ring.sqSize);
+      }
+      ::close(ring.fd);
+    }
+
+    bool supportsOps(int fd)
+    {
+      const size_t ops = 256;
+      std::vector< char > mem(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op), 0);
+      io_uring_probe * probe = reinterpret_cast< io_uring_probe * >(mem.data());
+      if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops) < 0) {
+        return false;
+      }
+      const unsigned char needed[] = {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE};
+      for (unsigned char op: needed) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool openUring(Uring & ring, unsigned entries)
+    {
+      io_uring_params params = {};
+      int fd = static_cast< int >(::syscall(__NR_io_uring_setup, entries, &params));
+      if (fd < 0) {
+        return false;
+      }
+      ring = Uring{fd, nullptr, nullptr, 0, nullptr, nullptr, nullptr, 0, nullptr, nullptr, nullptr, 0, nullptr, 0, 0, 0};
+      if (!supportsOps(fd)) {
+        closeUring(ring);
+        return false;
+      }
+      ring.sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      ring.cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+      if (single) {
+        ring.sqSize = ring.cqSize = std::max(ring.sqSize, ring.cqSize);
+      }
+      const int prot = PROT_READ | PROT_WRITE;
+      const int flags = MAP_SHARED | MAP_POPULATE;
+      void * sq = ::mmap(nullptr, ring.sqSize, prot, flags, fd, IORING_OFF_SQ_RING);
+      if (sq == MAP_FAILED) {
+        closeUring(ring);
+        return false;
+      }
+      ring.sqRing = sq;
+      void * cq = single ? sq : ::mmap(nullptr, ring.cqSize, prot, flags, fd, IORING_OFF_CQ_RING);
+      if (cq == MAP_FAILED) {
+        closeUring(ring);
+        return false;
+      }
+      ring.cqRing = cq;
+      ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+      void * sqes = ::mmap(nullptr, ring.sqesSize, prot, flags, fd, IORING_OFF_SQES);
+      if (sqes == MAP_FAILED) {
+        closeUring(ring);
+        return false;
+      }
+      ring.sqes = static_cast< io_uring_sqe * >(sqes);
+      ring.sqHead = ringField< unsigned >(sq, params.sq_off.head);
+      ring.sqTail = ringField< unsigned >(sq, params.sq_off.tail);
+      ring.sqMask = *ringField< unsigned >(sq, params.sq_off.ring_mask);
+      ring.sqArray = ringField< unsigned >(sq, params.sq_off.array);
+      ring.cqHead = ringField< unsigned >(cq, params.cq_off.head);
+      ring.cqTail = ringField< unsigned >(cq, params.cq_off.tail);
+      ring.cqMask = *ringField< unsigned >(cq, params.cq_off.ring_mask);
+      ring.cqes = ringField< io_uring_cqe >(cq, params.cq_off.cqes);
+      return true;
+    }
+
+    io_uring_sqe & nextSqe(Uring & ring)
+    {
+      unsigned tail = *ring.sqTail;
+      unsigned idx = tail & ring.sqMask;
+      io_uring_sqe & sqe = ring.sqes[idx];
+      std::memset(&sqe, 0, sizeof(sqe));
+      ring.sqArray[idx] = idx;
+      __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+      ++ring.pending;
+      return sqe;
+    }
+
+    void prepOpen(Uring & ring, size_t slot, const std::string & path)
+    {
+      io_uring_sqe & sqe = nextSqe(ring);
+      sqe.opcode = IORING_OP_OPENAT;
+      sqe.fd = AT_FDCWD;
+      sqe.addr = reinterpret_cast< uintptr_t >(path.c_str());
+      sqe.open_flags = O_RDONLY | O_CLOEXEC;
+      sqe.user_data = slot * 4 + OP_OPEN;
+    }
+
+    void prepRead(Uring & ring, size_t slot, UringSlot & s)
+    {
+      if (s.buf.size() - s.len < READ_CHUNK / 4) {
+        s.buf.resize(s.buf.size() * 2);
+      }
+      io_uring_sqe & sqe = nextSqe(ring);
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = s.fd;
+      sqe.addr = reinterpret_cast< uintptr_t >(s.buf.data() + s.len);
+      sqe.len = static_cast< unsigned >(std::min< size_t >(s.buf.size() - s.len, UINT_MAX));
+      sqe.off = s.len;
+      sqe.user_data = slot * 4 + OP_READ;
+    }
+
+    void prepClose(Uring & ring, size_t slot, int fd)
+    {
+      io_uring_sqe & sqe = nextSqe(ring);
+      sqe.opcode = IORING_OP_CLOSE;
+      sqe.fd = fd;
+      sqe.user_data = slot * 4 + OP_CLOSE;
+    }
+#endif
+  }
+}
+
+zharov::LoaderEngine zharov::getLoaderEngine(const char * name)
+{
+  if (name && std::strcmp(name, "threads") == 0) {
+    return LoaderEngine::THREADS;
+  } else if (name && std::strcmp(name, "stream") == 0) {
+    return LoaderEngine::STREAM;
+  }
+  return LoaderEngine::URING;
+}
+
+const char * zharov::getEngineName(LoaderEngine engine)
+{
+  switch (engine) {
+  case LoaderEngine::URING:
+    return "uring";
+  case LoaderEngine::THREADS:
+    return "threads";
+  case LoaderEngine::STREAM:
+    return "stream";
+  }
+  return "unknown";
+}
+
+bool zharov::loadFilesUring(const std::vector< std::string > & paths, size_t depth, const FileHandler & handler)
+{
+#ifdef ZHAROV_HAS_URING
+  Uring ring = {};
+  size_t slots = std::max< size_t >(1, std::min(depth, paths.size()));
+  if (paths.empty() || !openUring(ring, static_cast< unsigned >(slots))) {
+    return paths.empty();
+  }
+  std::vector< UringSlot > slot(slots);
+  size_t next = 0;
+  size_t active = 0;
+  for (size_t k = 0; k < slots; ++k) {
+    slot[k] = UringSlot{next, -1, 0, std::vector< char >(READ_CHUNK)};
+    prepOpen(ring, k, paths[next++]);
+    ++active;
+  }
+  auto refill = [&](size_t k) {
+    if (next < paths.size()) {
+      slot[k].index = next;
+      slot[k].fd = -1;
+      slot[k].len = 0;
+      prepOpen(ring, k, paths[next++]);
+    } else {
+      --active;
+    }
+  };
+  while (active) {
+    int res = static_cast< int >(::syscall(__NR_io_uring_enter, ring.fd, ring.pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (res < 0 && errno != EINTR) {
+      break;
+    }
+    ring.pending = res > 0 ? ring.pending - std::min< unsigned >(ring.pending, res) : ring.pending;
+    unsigned head = *ring.cqHead;
+    unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe & cqe = ring.cqes[head & ring.cqMask];
+      size_t k = cqe.user_data / 4;
+      UringSlot & s = slot[k];
+      switch (cqe.user_data % 4) {
+      case OP_OPEN:
+        if (cqe.res < 0) {
+          handler(s.index, nullptr, 0, false);
+          refill(k);
+        } else {
+          s.fd = cqe.res;
+          prepRead(ring, k, s);
+        }
+        break;
+      case OP_READ:
+        if (cqe.res < 0) {
+          handler(s.index, nullptr, 0, false);
+          prepClose(ring, k, s.fd);
+        } else if (cqe.res == 0 || s.len + cqe.res < s.buf.size()) {
+          s.len += cqe.res;
+          handler(s.index, s.buf.data(), s.len, true);
+          prepClose(ring, k, s.fd);
+        } else {
+          s.len += cqe.res;
+          prepRead(ring, k, s);
+        }
+        break;
+      default:
+        refill(k);
+        break;
+      }
+    }
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+  }
+  closeUring(ring);
+  return active == 0;
+#else
+  static_cast< void >(depth);
+  static_cast< void >(handler);
+  return paths.empty();
+#endif
+}
+
+void zharov::loadFilesThreads(const std::vector< std::string > & paths, size_t threads, const FileHandler & handler)
+{
+  std::atomic< size_t > next{0};
+  auto work = [&]() {
+    std::vector< char > buf;
+    for (size_t i = next++; i < paths.size(); i = next++) {
+      bool ok = readFile(paths[i], buf);
+      handler(i, buf.data(), buf.size(), ok);
+    }
+  };
+  std::vector< std::thread > workers;
+  try {
+    for (size_t t = 1; t < std::min(threads, paths.size()); ++t) {
+      workers.emplace_back(work);
+    }
+  } catch (const std::system_error &) {
+  }
+  work();
+  for (std::thread & w: workers) {
+    w.join();
+  }
+}
+
+void zharov::loadFilesStream(const std::vector< std::string > & paths, const FileHandler & handler)
+{
+  for (size_t i = 0; i < paths.size(); ++i) {
+    std::ifstream input(paths[i], std::ios::binary);
+    std::vector< char > buf((std::istreambuf_iterator< char >(input)), std::istreambuf_iterator< char >());
+    handler(i, buf.data(), buf.size(), input.is_open());
+  }
+}
+
+zharov::LoaderEngine zharov::loadFiles(const std::vector< std::string > & paths, LoaderEngine engine, const FileHandler & handler)
+{
+  if (engine == LoaderEngine::URING) {
+    if (loadFilesUring(paths, getEnvSize("ZHAROV_LOADER_DEPTH", 256), handler)) {
+      return engine;
+    }
+    engine = LoaderEngine::THREADS;
+  }
+  if (engine == LoaderEngine::THREADS) {
+    loadFilesThreads(paths, getEnvSize("ZHAROV_LOADER_THREADS", 32), handler);
+  } else {
+    loadFilesStream(paths, handler);
+  }
+  return engine;
+}
+
+bool zharov::parseMatrix(const char * data, size_t size, std::vector< int > & mtx, size_t & rows, size_t & cols)
+{
+  const char * end = data + size;
+  auto next = [&](long long & value) {
+    while (data != end && std::isspace(static_cast< unsigned char >(*data))) {
+      ++data;
+    }
+    bool neg = data != end && *data == '-';
+    data += (data != end && (*data == '-' || *data == '+'));
+    if (data == end || !std::isdigit(static_cast< unsigned char >(*data))) {
+      return false;
+    }
+    long long res = 0;
+    while (data != end && std::isdigit(static_cast< unsigned char >(*data))) {
+      res = res * 10 + (*data++ - '0');
+      if (res > INT_MAX + 1ll) {
+        return false;
+      }
+    }
+    value = neg ? -res : res;
+    return value >= INT_MIN && value <= INT_MAX;
+  };
+  long long r = 0, c = 0, v = 0;
+  if (!next(r) || !next(c) || r < 0 || c < 0) {
+    return false;
+  }
+  rows = static_cast< size_t >(r);
+  cols = static_cast< size_t >(c);
+  // every value takes at least a digit and a separator, so a header asking
+  // for more cells than that is rejected before anything is allocated
+  size_t left = static_cast< size_t >(end - data);
+  if (cols && rows > (left / 2 + 1) / cols) {
+    return false;
+  }
+  mtx.resize(rows * cols);
+  for (size_t i = 0; i < rows * cols; ++i) {
+    if (!next(v)) {
+      return false;
+    }
+    mtx[i] = static_cast< int >(v);
+  }
+  return true;
+}
+
+zharov::ManifestResult zharov::runManifestEntry(const char * data, size_t size, bool ok)
+{
+  try {
+    std::vector< int > mtx;
+    size_t rows = 0, cols = 0;
+    if (ok && parseMatrix(data, size, mtx, rows, cols)) {
+      return ManifestResult{true, isUppTriMtx(mtx.data(), rows, cols), getCntColNsm(mtx.data(), rows, cols)};
+    }
+  } catch (const std::exception &) {
+  }
+  return ManifestResult{false, false, 0};
+}
+
+int zharov::writeManifestResults(std::ostream & output, const std::vector< std::string > & paths, const std::vector< ManifestResult > & results)
+{
+  int status = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (results[i].ok) {
+      output << results[i].uppTri << "\n" << results[i].cntColNsm << "\n";
+    } else {
+      output << "-\n-\n";
+      std::cerr << "Bad read (" << paths[i] << ")\n";
+      status = 2;
+    }
+  }
+  return status;
+}
+
+int zharov::processManifest(std::istream & manifest, std::ostream & output)
+{
+  std::vector< std::string > paths;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (!line.empty()) {
+      paths.push_back(line);
+    }
+  }
+  std::vector< ManifestResult > results(paths.size(), ManifestResult{false, false, 0});
+  auto handler = [&results](size_t index, const char * data, size_t size, bool ok) {
+    results[index] = runManifestEntry(data, size, ok);
+  };
+  auto start = std::chrono::steady_clock::now();
+  LoaderEngine engine = loadFiles(paths, getLoaderEngine(std::getenv("ZHAROV_LOADER")), handler);
+  std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+  if (std::getenv("ZHAROV_LOADER_STATS")) {
+    double rate = elapsed.count() > 0 ? paths.size() / elapsed.count() : 0.0;
+    std::cerr << getEngineName(engine) << " " << paths.size() << " files " << elapsed.count() << " s " << rate << " files/s\n";
+  }
+  return writeManifestResults(output, paths, results);
+}
@@ -0,0 +1,40 @@
+#ifndef ZHAROV_LOADER_HPP
+#define ZHAROV_LOADER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace zharov
+{
+  enum class LoaderEngine {
+    URING,
+    THREADS,
+    STREAM
+  };
+
+  struct ManifestResult {
+    bool ok;
+    bool uppTri;
+    size_t cntColNsm;
+  };
+
+  using FileHandler = std::function< void(size_t index, const char * data, size_t size, bool ok) >;
+
+  LoaderEngine getLoaderEngine(const char * name);
+  const char * getEngineName(LoaderEngine engine);
+
+  bool loadFilesUring(const std::vector< std::string > & paths, size_t depth, const FileHandler & handler);
+  void loadFilesThreads(const std::vector< std::string > & paths, size_t threads, const FileHandler & handler);
+  void loadFilesStream(const std::vector< std::string > & paths, const FileHandler & handler);
+  LoaderEngine loadFiles(const std::vector< std::string > & paths, LoaderEngine engine, const FileHandler & handler);
+
+  bool parseMatrix(const char * data, size_t size, std::vector< int > & mtx, size_t & rows, size_t & cols);
+  ManifestResult runManifestEntry(const char * data, size_t size, bool ok);
+  int writeManifestResults(std::ostream & output, const std::vector< std::string > & paths, const std::vector< ManifestResult > & results);
+  int processManifest(std::istream & manifest, std::ostream & output);
+}
+
+#endif
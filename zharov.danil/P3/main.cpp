@@ -2,12 +2,18 @@
 #include <fstream>
 #include <memory>
 #include <cctype>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include "batch.hpp"
+#include "col_queries.hpp"
+#include "loader.hpp"
+#include "matrix.hpp"
+#include "sched.hpp"
 
 namespace zharov
 {
   std::istream & inputMatrix(std::istream & input, int * mtx, size_t rows, size_t cols);
-  bool isUppTriMtx(const int * mtx, size_t rows, size_t cols);
-  size_t getCntColNsm(const int * mtx, size_t rows, size_t cols);
   void processMatrix(std::ifstream & input, int * matrix, size_t rows, size_t cols, const char * output_file);
 }
 
@@ -30,6 +36,53 @@ int main(int argc, char ** argv)
     return 1;
   }
 
+  if (std::getenv("ZHAROV_SCHED_REPLAY")) {
+    std::ifstream trace(argv[2]);
+    if (!trace.is_open()) {
+      std::cerr << "Can't open file\n";
+      return 2;
+    }
+    std::ofstream output(argv[3]);
+    if (zharov::processReplay(trace, output) != 0) {
+      std::cerr << "Bad read (replay trace)\n";
+      return 2;
+    }
+    return 0;
+  }
+  if (std::getenv("ZHAROV_MANIFEST")) {
+    std::ifstream manifest(argv[2]);
+    if (!manifest.is_open()) {
+      std::cerr << "Can't open file\n";
+      return 2;
+    }
+    std::ofstream output(argv[3]);
+    if (std::getenv("ZHAROV_SCHED")) {
+      return zharov::processManifestScheduled(manifest, output);
+    }
+    return zharov::processManifest(manifest, output);
+  }
+  if (std::getenv("ZHAROV_BATCH")) {
+    std::ifstream input(argv[2]);
+    if (!input.is_open()) {
+      std::cerr << "Can't open file\n";
+      return 2;
+    }
+    std::ofstream output(argv[3]);
+    try {
+      if (zharov::processStream(input, output) != 0) {
+        std::cerr << "Bad read (batch matrix)\n";
+        return 2;
+      }
+    } catch (const std::bad_alloc &) {
+      std::cerr << "Bad alloc\n";
+      return 2;
+    } catch (const std::length_error &) {
+      std::cerr << "Bad alloc\n";
+      return 2;
+    }
+    return 0;
+  }
+
   size_t rows = 0, cols = 0;
   std::ifstream input(argv[2]);
   input >> rows >> cols;
@@ -73,45 +126,6 @@ std::istream & zharov::inputMatrix(std::istream & input, int * mtx, size_t rows,
   return input;
 }
 
-bool zharov::isUppTriMtx(const int * mtx, size_t rows, size_t cols)
-{
-  if (rows != cols) {
-    rows = std::min(rows, cols);
-    cols = rows;
-  }
-
-  if (rows == 0) {
-    return false;
-  }
-
-  for (size_t i = 0; i < rows; ++i) {
-    for (size_t j = 0; j < i; ++j) {
-      if (mtx[cols * i + j] != 0) {
-        return false;
-      }
-    }
-  }
-  return true;
-}
-
-size_t zharov::getCntColNsm(const int * mtx, size_t rows, size_t cols)
-{
-  if (rows == 0 || cols == 0) {
-    return 0;
-  }
-
-  size_t res = cols;
-  for (size_t i = 0; i < cols; ++i) {
-    for (size_t j = 1; j < rows; ++j) {
-      if (mtx[j * cols + i] == mtx[(j - 1) * cols + i]) {
-        --res;
-        break;
-      }
-    }
-  }
-  return res;
-}
-
 void zharov::processMatrix(std::ifstream & input, int * matrix, size_t rows, size_t cols, const char * output_file)
 {
   zharov::inputMatrix(input, matrix, rows, cols);
@@ -121,4 +135,16 @@ void zharov::processMatrix(std::ifstream & input, int * matrix, size_t rows, siz
   std::ofstream output(output_file);
   output << zharov::isUppTriMtx(matrix, rows, cols) << "\n";
   output << zharov::getCntColNsm(matrix, rows, cols) << "\n";
+
+  const char * queries_file = std::getenv("ZHAROV_COL_QUERIES");
+  if (queries_file) {
+    std::ifstream queries(queries_file);
+    const char * answers_file = std::getenv("ZHAROV_COL_QUERIES_OUT");
+    if (answers_file) {
+      std::ofstream answers(answers_file);
+      zharov::processColQueries(queries, answers, matrix, rows, cols);
+    } else {
+      zharov::processColQueries(queries, std::cout, matrix, rows, cols);
+    }
+  }
 }
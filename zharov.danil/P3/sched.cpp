@@ -0,0 +1,384 @@
+#include "sched.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include "loader.hpp"
+#include "matrix.hpp"
+
+namespace zharov
+{
+  namespace
+  {
+    const size_t CALIBRATE_MIN_SIDE = 32;
+    const double CALIBRATE_MIN_TIME = 0.002;
+
+    size_t getEnvSize(const char * name, size_t def)
+    {
+      const char * value = std::getenv(name);
+      if (!value || !*value) {
+        return def;
+      }
+      char * end = nullptr;
+      unsigned long long res = std::strtoull(value, &end, 10);
+      return (*end == '\0' && res) ? static_cast< size_t >(res) : def;
+    }
+
+    double getEnvDouble(const char * name, double def)
+    {
+      const char * value = std::getenv(name);
+      if (!value || !*value) {
+        return def;
+      }
+      char * end = nullptr;
+      double res = std::strtod(value, &end);
+      return (*end == '\0' && res >= 0.0) ? res : def;
+    }
+
+    size_t getTriCells(size_t rows, size_t cols)
+    {
+      size_t side = std::min(rows, cols);
+      return side * (side ? side - 1 : 0) / 2;
+    }
+
+    // Seconds per call of f, repeated until the total is long enough to
+    // be above the clock resolution.
+    double timeCall(const std::function< void() > & f)
+    {
+      using clock = std::chrono::steady_clock;
+      size_t reps = 0;
+      auto start = clock::now();
+      std::chrono::duration< double > elapsed{0};
+      do {
+        f();
+        ++reps;
+        elapsed = clock::now() - start;
+      } while (elapsed.count() < CALIBRATE_MIN_TIME);
+      return elapsed.count() / reps;
+    }
+
+    // Least squares slope of t over x for a line through the origin.
+    double fitSlope(const std::vector< double > & x, const std::vector< double > & t)
+    {
+      double xt = 0.0, xx = 0.0;
+      for (size_t i = 0; i < x.size(); ++i) {
+        xt += x[i] * t[i];
+        xx += x[i] * x[i];
+      }
+      return xx > 0.0 ? std::max(xt / xx, 0.0) : 0.0;
+    }
+
+    std::string makeMatrixText(size_t rows, size_t cols)
+    {
+      std::string text = std::to_string(rows) + " " + std::to_string(cols);
+      for (size_t i = 0; i < rows * cols; ++i) {
+        text += " " + std::to_string(i % 1000);
+      }
+      return text;
+    }
+
+    bool readHeader(const std::string & path, size_t & rows, size_t & cols)
+    {
+      std::ifstream input(path);
+      rows = 0;
+      cols = 0;
+      return static_cast< bool >(input >> rows >> cols);
+    }
+  }
+}
+
+zharov::CostModel zharov::getDefaultCostModel()
+{
+  return CostModel{1.5e-7, 4e-8, 3e-9, 8e-9};
+}
+
+zharov::CostModel zharov::calibrateCostModel(size_t maxSide)
+{
+  CostModel model = getDefaultCostModel();
+  std::vector< int > parsed;
+  size_t rows = 0, cols = 0;
+  std::string tiny = makeMatrixText(1, 1);
+  volatile size_t sink = 0;
+  model.base = timeCall([&]() {
+    parseMatrix(tiny.data(), tiny.size(), parsed, rows, cols);
+    sink = sink + isUppTriMtx(parsed.data(), rows, cols) + getCntColNsm(parsed.data(), rows, cols);
+  });
+
+  std::vector< double > cells, triCells, parseTimes, uppTriTimes, colNsmTimes;
+  for (size_t side = CALIBRATE_MIN_SIDE; side <= std::max(maxSide, CALIBRATE_MIN_SIDE); side *= 2) {
+    std::string text = makeMatrixText(side, side);
+    parseTimes.push_back(timeCall([&]() {
+      parseMatrix(text.data(), text.size(), parsed, rows, cols);
+    }));
+    // a zero matrix is upper triangular and a counting one has no equal
+    // neighbours, so both kernels run to the end
+    std::vector< int > zeros(side * side, 0);
+    uppTriTimes.push_back(timeCall([&]() {
+      sink = sink + isUppTriMtx(zeros.data(), side, side);
+    }));
+    colNsmTimes.push_back(timeCall([&]() {
+      sink = sink + getCntColNsm(parsed.data(), side, side);
+    }));
+    cells.push_back(static_cast< double >(side * side));
+    triCells.push_back(static_cast< double >(getTriCells(side, side)));
+  }
+  model.parseCell = fitSlope(cells, parseTimes);
+  model.uppTriCell = fitSlope(triCells, uppTriTimes);
+  model.colNsmCell = fitSlope(cells, colNsmTimes);
+  return model;
+}
+
+bool zharov::loadCostModel(const char * path, CostModel & model)
+{
+  std::ifstream input(path);
+  CostModel res = {};
+  if (!(input >> res.base >> res.parseCell >> res.uppTriCell >> res.colNsmCell)) {
+    return false;
+  }
+  model = res;
+  return true;
+}
+
+bool zharov::saveCostModel(const char * path, const CostModel & model)
+{
+  std::ofstream output(path);
+  output.precision(std::numeric_limits< double >::max_digits10);
+  output << model.base << " " << model.parseCell << " " << model.uppTriCell << " " << model.colNsmCell << "\n";
+  return static_cast< bool >(output);
+}
+
+zharov::CostModel zharov::getCostModel(const char * profile)
+{
+  CostModel model = getDefaultCostModel();
+  if (profile && *profile && !loadCostModel(profile, model)) {
+    model = calibrateCostModel(getEnvSize("ZHAROV_COST_SIDE", 1024));
+    if (!saveCostModel(profile, model)) {
+      std::cerr << "Can't save cost profile\n";
+    }
+  }
+  return model;
+}
+
+double zharov::predictCost(const CostModel & model, size_t rows, size_t cols, unsigned kernels, bool parse)
+{
+  double cells = static_cast< double >(rows) * static_cast< double >(cols);
+  double cost = model.base;
+  cost += parse ? model.parseCell * cells : 0.0;
+  cost += (kernels & UPP_TRI_KERNEL) ? model.uppTriCell * static_cast< double >(getTriCells(rows, cols)) : 0.0;
+  cost += (kernels & COL_NSM_KERNEL) ? model.colNsmCell * cells : 0.0;
+  return cost;
+}
+
+zharov::SchedulerConfig zharov::getSchedulerConfig(size_t workers)
+{
+  const char * policy = std::getenv("ZHAROV_SCHED");
+  SchedulerConfig config = {};
+  config.sjf = !policy || std::string(policy) != "fifo";
+  config.aging = getEnvDouble("ZHAROV_SCHED_AGING", 1.0);
+  config.largeCost = getEnvDouble("ZHAROV_SCHED_LARGE", 0.05);
+  config.largeWorkers = std::min(getEnvSize("ZHAROV_SCHED_LARGE_WORKERS", workers > 1 ? workers - 1 : 1), workers);
+  return config;
+}
+
+bool zharov::JobQueue::Entry::operator<(const Entry & rhs) const
+{
+  return key > rhs.key || (key == rhs.key && seq > rhs.seq);
+}
+
+zharov::JobQueue::JobQueue(const SchedulerConfig & config):
+  config_(config),
+  seq_(0)
+{}
+
+void zharov::JobQueue::push(const Job & job)
+{
+  Entry entry{config_.sjf ? job.cost + config_.aging * job.arrival : job.arrival, seq_++, job};
+  if (isLarge(job)) {
+    large_.push(entry);
+  } else {
+    small_.push(entry);
+  }
+}
+
+bool zharov::JobQueue::pop(bool allowLarge, Job & job)
+{
+  bool takeLarge = allowLarge && !large_.empty() && (small_.empty() || small_.top() < large_.top());
+  std::priority_queue< Entry > & lane = takeLarge ? large_ : small_;
+  if (lane.empty()) {
+    return false;
+  }
+  job = lane.top().job;
+  lane.pop();
+  return true;
+}
+
+bool zharov::JobQueue::isLarge(const Job & job) const
+{
+  return config_.sjf && job.cost >= config_.largeCost;
+}
+
+bool zharov::JobQueue::empty() const
+{
+  return small_.empty() && large_.empty();
+}
+
+zharov::LatencyStats zharov::getLatencyStats(std::vector< double > latencies)
+{
+  if (latencies.empty()) {
+    return LatencyStats{0.0, 0.0, 0.0};
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0.0;
+  for (double l: latencies) {
+    sum += l;
+  }
+  size_t p99 = static_cast< size_t >(std::ceil(0.99 * latencies.size())) - 1;
+  return LatencyStats{sum / latencies.size(), latencies[p99], latencies.back()};
+}
+
+zharov::LatencyStats zharov::replaySchedule(const std::vector< Job > & jobs, size_t workers, const SchedulerConfig & config)
+{
+  using Running = std::pair< double, bool >;
+  std::vector< size_t > order(jobs.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+    return jobs[a].arrival < jobs[b].arrival;
+  });
+  JobQueue queue(config);
+  std::priority_queue< Running, std::vector< Running >, std::greater< Running > > running;
+  std::vector< double > latencies;
+  size_t next = 0, idle = std::max< size_t >(workers, 1), runningLarge = 0;
+  double now = 0.0;
+  while (latencies.size() < jobs.size()) {
+    for (; next < order.size() && jobs[order[next]].arrival <= now; ++next) {
+      queue.push(jobs[order[next]]);
+    }
+    Job job = {};
+    while (idle > 0 && queue.pop(runningLarge < config.largeWorkers, job)) {
+      bool large = queue.isLarge(job);
+      runningLarge += large;
+      --idle;
+      running.push(Running{now + job.cost, large});
+      latencies.push_back(now + job.cost - job.arrival);
+    }
+    double until = next < order.size() ? jobs[order[next]].arrival : std::numeric_limits< double >::infinity();
+    now = running.empty() ? until : std::min(until, running.top().first);
+    while (!running.empty() && running.top().first <= now) {
+      runningLarge -= running.top().second;
+      ++idle;
+      running.pop();
+    }
+  }
+  return getLatencyStats(latencies);
+}
+
+int zharov::processReplay(std::istream & trace, std::ostream & output)
+{
+  CostModel model = getCostModel(std::getenv("ZHAROV_COST_PROFILE"));
+  std::vector< Job > jobs;
+  double arrival = 0.0;
+  size_t rows = 0, cols = 0;
+  while (trace >> arrival >> rows >> cols) {
+    jobs.push_back(Job{jobs.size(), arrival, predictCost(model, rows, cols, ALL_KERNELS, true)});
+  }
+  if (!trace.eof()) {
+    return 2;
+  }
+  size_t workers = getEnvSize("ZHAROV_SCHED_THREADS", std::max(std::thread::hardware_concurrency(), 1u));
+  SchedulerConfig sched = getSchedulerConfig(workers);
+  sched.sjf = true;
+  SchedulerConfig fifo = sched;
+  fifo.sjf = false;
+  SchedulerConfig sjf = sched;
+  sjf.aging = 0.0;
+  sjf.largeCost = std::numeric_limits< double >::infinity();
+  const char * names[] = {"fifo", "sjf", "sjf+aging+lane"};
+  const SchedulerConfig * configs[] = {&fifo, &sjf, &sched};
+  output << jobs.size() << " jobs " << workers << " workers\n";
+  output << "policy mean p99 max\n";
+  for (size_t i = 0; i < 3; ++i) {
+    LatencyStats stats = replaySchedule(jobs, workers, *configs[i]);
+    output << names[i] << " " << stats.mean << " " << stats.p99 << " " << stats.max << "\n";
+  }
+  return 0;
+}
+
+int zharov::processManifestScheduled(std::istream & manifest, std::ostream & output)
+{
+  std::vector< std::string > paths;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (!line.empty()) {
+      paths.push_back(line);
+    }
+  }
+  CostModel model = getCostModel(std::getenv("ZHAROV_COST_PROFILE"));
+  size_t workers = std::min(getEnvSize("ZHAROV_SCHED_THREADS", std::max(std::thread::hardware_concurrency(), 1u)), std::max< size_t >(paths.size(), 1));
+  SchedulerConfig config = getSchedulerConfig(workers);
+  JobQueue queue(config);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    size_t rows = 0, cols = 0;
+    readHeader(paths[i], rows, cols);
+    queue.push(Job{i, 0.0, predictCost(model, rows, cols, ALL_KERNELS, true)});
+  }
+
+  std::vector< ManifestResult > results(paths.size(), ManifestResult{false, false, 0});
+  std::vector< double > latencies(paths.size(), 0.0);
+  std::mutex lock;
+  size_t runningLarge = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto work = [&]() {
+    Job job = {};
+    while (true) {
+      bool large = false;
+      {
+        std::lock_guard< std::mutex > guard(lock);
+        if (!queue.pop(runningLarge < config.largeWorkers, job)) {
+          return;
+        }
+        large = queue.isLarge(job);
+        runningLarge += large;
+      }
+      try {
+        std::vector< std::string > one(1, paths[job.id]);
+        loadFilesStream(one, [&](size_t, const char * data, size_t size, bool ok) {
+          results[job.id] = runManifestEntry(data, size, ok);
+        });
+      } catch (const std::exception &) {
+      }
+      std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+      latencies[job.id] = elapsed.count();
+      std::lock_guard< std::mutex > guard(lock);
+      runningLarge -= large;
+    }
+  };
+  std::vector< std::thread > threads;
+  try {
+    for (size_t t = 1; t < workers; ++t) {
+      threads.emplace_back(work);
+    }
+  } catch (const std::system_error &) {
+  }
+  work();
+  for (std::thread & t: threads) {
+    t.join();
+  }
+
+  if (std::getenv("ZHAROV_SCHED_STATS")) {
+    LatencyStats stats = getLatencyStats(latencies);
+    std::cerr << (config.sjf ? "sjf" : "fifo") << " " << paths.size() << " files " << workers << " workers";
+    std::cerr << " mean " << stats.mean << " s p99 " << stats.p99 << " s max " << stats.max << " s\n";
+  }
+  return writeManifestResults(output, paths, results);
+}
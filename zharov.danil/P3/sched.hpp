@@ -0,0 +1,88 @@
+#ifndef ZHAROV_SCHED_HPP
+#define ZHAROV_SCHED_HPP
+
+#include <cstddef>
+#include <iosfwd>
+#include <queue>
+#include <vector>
+
+namespace zharov
+{
+  enum KernelMask : unsigned {
+    UPP_TRI_KERNEL = 1,
+    COL_NSM_KERNEL = 2,
+    ALL_KERNELS = UPP_TRI_KERNEL | COL_NSM_KERNEL
+  };
+
+  // Predicted seconds per job: a fixed part plus per-cell terms for text
+  // parsing and every kernel that runs. Coefficients come from calibrate.
+  struct CostModel {
+    double base;
+    double parseCell;
+    double uppTriCell;
+    double colNsmCell;
+  };
+
+  CostModel getDefaultCostModel();
+  CostModel calibrateCostModel(size_t maxSide);
+  bool loadCostModel(const char * path, CostModel & model);
+  bool saveCostModel(const char * path, const CostModel & model);
+  CostModel getCostModel(const char * profile);
+  double predictCost(const CostModel & model, size_t rows, size_t cols, unsigned kernels, bool parse);
+
+  struct Job {
+    size_t id;
+    double arrival;
+    double cost;
+  };
+
+  struct SchedulerConfig {
+    bool sjf;
+    double aging;
+    double largeCost;
+    size_t largeWorkers;
+  };
+
+  SchedulerConfig getSchedulerConfig(size_t workers);
+
+  // Jobs are ordered by cost - aging * waited. The waiting credit grows at
+  // the same rate for every queued job, so the order is fixed by the key
+  // cost + aging * arrival and a plain heap is enough. Jobs predicted to
+  // cost at least largeCost wait in their own lane and only largeWorkers
+  // of them run at a time, which keeps the other workers for small jobs.
+  class JobQueue {
+  public:
+    explicit JobQueue(const SchedulerConfig & config);
+
+    void push(const Job & job);
+    bool pop(bool allowLarge, Job & job);
+    bool isLarge(const Job & job) const;
+    bool empty() const;
+
+  private:
+    struct Entry {
+      double key;
+      size_t seq;
+      Job job;
+      bool operator<(const Entry & rhs) const;
+    };
+
+    SchedulerConfig config_;
+    size_t seq_;
+    std::priority_queue< Entry > small_;
+    std::priority_queue< Entry > large_;
+  };
+
+  struct LatencyStats {
+    double mean;
+    double p99;
+    double max;
+  };
+
+  LatencyStats getLatencyStats(std::vector< double > latencies);
+  LatencyStats replaySchedule(const std::vector< Job > & jobs, size_t workers, const SchedulerConfig & config);
+  int processReplay(std::istream & trace, std::ostream & output);
+  int processManifestScheduled(std::istream & manifest, std::ostream & output);
+}
+
+#endif